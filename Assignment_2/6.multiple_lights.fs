@@ -15,15 +15,14 @@ struct DirLight {
     vec3 specular;
 };
 
+// members ordered so the floats fill the std140 gaps after the vec3s (LightBuffer in light_buffer.h)
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
@@ -42,18 +41,59 @@ struct SpotLight {
     vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 3
+// has to match LightBuffer::kMaxPointLights
+#define MAX_POINT_LIGHTS 64
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
 uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+// written by LightBuffer, only the first pointLightCount lights are valid
+layout(std140) uniform LightBlock {
+    DirLight dirLight;
+    int pointLightCount;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
 uniform SpotLight spotLight;
 uniform Material material;
 
+// clustered point lights: copy of Final_Project/clustered_lighting.glsl (shader_m.h can't #include it), change that one first
+layout(std140) uniform ClusterBlock {
+    vec4 clusterDepthRow; // dot with (worldPos, 1) = view depth
+    vec4 clusterScale;    // xy: tiles per pixel, z / w: slice = log(depth) * z + w
+    ivec4 clusterGrid;    // tiles x, tiles y, slices, light count
+};
+uniform samplerBuffer clusterLights;   // 2 texels per light: position + radius, color
+uniform usamplerBuffer clusterRanges;  // per cluster: first entry in clusterIndices, light count
+uniform usamplerBuffer clusterIndices;
+
+// diffuse and specular light of the lights in this fragment's cluster (windowed inverse-square falloff)
+void ClusteredLighting(vec3 fragPos, vec3 normal, vec3 viewDir, float shininess, out vec3 diffuse, out vec3 specular)
+{
+    diffuse = vec3(0.0);
+    specular = vec3(0.0);
+    float depth = max(dot(clusterDepthRow, vec4(fragPos, 1.0)), 1e-4);
+    ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * clusterScale.xy), int(floor(log(depth) * clusterScale.z + clusterScale.w)));
+    cell = clamp(cell, ivec3(0), clusterGrid.xyz - 1);
+    uvec2 range = texelFetch(clusterRanges, (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x).xy;
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w)
+            continue;
+        vec3 lightDir = toLight / distance;
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        diffuse += color * max(dot(normal, lightDir), 0.0) * attenuation;
+        specular += color * pow(max(dot(viewDir, reflect(-lightDir, normal)), 0.0), shininess) * attenuation;
+    }
+}
+
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
@@ -74,8 +114,13 @@ void main()
     // phase 1: directional lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
     // phase 2: point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+    for(int i = 0; i < pointLightCount; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // phase 2b: the glowing cubes, only those whose light reaches this fragment's cluster
+    vec3 clusterDiffuse, clusterSpecular;
+    ClusteredLighting(FragPos, norm, viewDir, material.shininess, clusterDiffuse, clusterSpecular);
+    result += clusterDiffuse * vec3(texture(material.diffuse, TexCoords));
+    result += clusterSpecular * vec3(texture(material.specular, TexCoords));
     // phase 3: spot light
     //result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
     
@@ -0,0 +1,32 @@
+#version 330 core
+// 6.multiple_lights.vs for IndirectDraw (GL 4.3 contexts): each cube's matrices come from the
+// draw's entry in the storage buffer instead of the model uniform
+#extension GL_ARB_shader_storage_buffer_object : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 7) in uint drawIndex; // the command's baseInstance
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+struct DrawData {
+    mat4 model;
+    mat4 normalMatrix;
+};
+layout(std430) readonly buffer DrawBlock {
+    DrawData draws[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(draws[drawIndex].model * vec4(aPos, 1.0));
+    Normal = mat3(draws[drawIndex].normalMatrix) * aNormal;
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
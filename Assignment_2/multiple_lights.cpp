@@ -9,6 +9,13 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/light_buffer.h>
+#include <learnopengl/clustered_lights.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/render_graph.h>
+#include <learnopengl/dynamic_resolution.h>
+#include <learnopengl/indirect_draw.h>
 
 #include <iostream>
 
@@ -35,33 +42,92 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-//orbit cube drawing function
-void DrawOrbitingCubes(Shader& lightingShader,
-    glm::vec3 orbitCenter, float a, float b,
-    float numCubes, float time,
-    glm::vec3 planeTiltAxis,
-    float planeTiltAngle,
-    glm::vec3 xyTiltAxis,
-    float xyTiltAngle)
+// culling: rebuilt from projection * view every frame
+Frustum viewFrustum;
+const float cubeRadius = 0.87f; // unit cube half-diagonal, covers any rotation
+
+// glowing cubes: every other orbiting cube and all floating ones are clustered point lights
+const glm::vec3 glowColor(2.0f, 0.25f, 0.2f);
+const float glowRadius = 6.0f;
+
+// one elliptic ring of cubes, tilted twice
+struct OrbitRing {
+    glm::vec3 center;
+    float a, b;
+    float numCubes;
+    float timeScale;
+    glm::vec3 planeTiltAxis;
+    float planeTiltAngle;
+    glm::vec3 xyTiltAxis;
+    float xyTiltAngle;
+};
+
+const OrbitRing orbitRings[] = {
+    { glm::vec3(8.0f, 3.0f, -20.0f), 30.0f, 45.0f, 50, 0.10f, glm::vec3(1.0f, 0.0f, 0.0f), 10.0f, glm::vec3(0.0f, 1.0f, 0.0f), 55.0f },
+    { glm::vec3(3.0f, 3.0f, -25.0f), 30.0f, 50.0f, 45, 0.10f, glm::vec3(1.0f, 0.0f, 0.0f), 20.0f, glm::vec3(0.0f, 1.0f, 0.0f), 55.0f },
+    { glm::vec3(-10.0f, 0.0f, -20.0f), 40.0f, 45.0f, 40, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), 20.0f, glm::vec3(0.0f, 1.0f, 0.0f), -30.0f },
+    { glm::vec3(-10.0f, 0.0f, -20.0f), 40.0f, 50.0f, 50, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), 20.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f },
+    { glm::vec3(-15.0f, 0.0f, -30.0f), 45.0f, 25.0f, 50, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), 30.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f },
+    { glm::vec3(-15.0f, 0.0f, -25.0f), 45.0f, 25.0f, 40, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), 30.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f },
+    { glm::vec3(-10.0f, 0.0f, -20.0f), 40.0f, 50.0f, 40, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), -10.0f, glm::vec3(0.0f, 1.0f, 0.0f), -30.0f },
+    { glm::vec3(-10.0f, 0.0f, -20.0f), 40.0f, 55.0f, 50, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), -10.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f },
+    { glm::vec3(-15.0f, 0.0f, -30.0f), 45.0f, 30.0f, 50, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), -10.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f },
+    { glm::vec3(-15.0f, 0.0f, -25.0f), 45.0f, 35.0f, 40, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), -10.0f, glm::vec3(0.0f, 1.0f, 0.0f), -40.0f }
+};
+
+// where cube i of the ring is, ringTime = time * ring.timeScale
+glm::vec3 OrbitPosition(const OrbitRing& ring, unsigned int i, float ringTime)
 {
-    glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), glm::radians(planeTiltAngle), planeTiltAxis);
-    glm::mat4 xyTilt = glm::rotate(glm::mat4(1.0f), glm::radians(xyTiltAngle), xyTiltAxis);
+    glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), glm::radians(ring.planeTiltAngle), ring.planeTiltAxis);
+    glm::mat4 xyTilt = glm::rotate(glm::mat4(1.0f), glm::radians(ring.xyTiltAngle), ring.xyTiltAxis);
 
-    for (unsigned int i = 0; i < (int)numCubes; i++)
+    float angle = (ringTime * 0.1f) + i * glm::radians(360.0f / ring.numCubes);
+    glm::vec4 orbitPos(ring.a * cos(angle), 0.0f, ring.b * sin(angle), 1.0f);
+
+    orbitPos = tilt * orbitPos;
+    orbitPos = xyTilt * orbitPos;
+    orbitPos += glm::vec4(ring.center, 0.0f);
+    return glm::vec3(orbitPos);
+}
+
+// adds the ring's glowing cubes to lights
+void AddOrbitLights(ClusteredLights& lights, const OrbitRing& ring, float time)
+{
+    for (unsigned int i = 0; i < (unsigned int)ring.numCubes; i += 2)
+        lights.Add(OrbitPosition(ring, i, time * ring.timeScale), glowRadius, glowColor);
+}
+
+// floating cube i: its base position bobbing up and down
+glm::vec3 FloatingCubePosition(glm::vec3 base, unsigned int i, float time)
+{
+    base.y += sin(time * 0.8f + i * 0.6f) * 0.5f;
+    return base;
+}
+
+// queues the ring's visible cubes, drawn front to back when the queue executes
+// (or into indirect, all in one call, when the context has multi-draw-indirect)
+void EnqueueOrbitingCubes(RenderQueue& renderQueue, const Shader& lightingShader, unsigned int cubeVAO, const Material& cubeMaterial,
+    const OrbitRing& ring, float time, IndirectDraw* indirect = nullptr)
+{
+    time *= ring.timeScale;
+    for (unsigned int i = 0; i < (unsigned int)ring.numCubes; i++)
     {
         glm::mat4 model = glm::mat4(1.0f);
-        float angle = (time * 0.1f) + i * glm::radians(360.0f / numCubes);
-        glm::vec4 orbitPos(a * cos(angle), 0.0f, b * sin(angle), 1.0f);
+        glm::vec3 orbitPos = OrbitPosition(ring, i, time);
 
-        orbitPos = tilt * orbitPos;
-        orbitPos = xyTilt * orbitPos;
-        orbitPos += glm::vec4(orbitCenter, 0.0f);
+        // cubes behind the camera or off to the side never reach the GPU
+        if (!viewFrustum.Intersects(BoundingSphere(orbitPos, cubeRadius)))
+            continue;
 
-        model = glm::translate(model, glm::vec3(orbitPos));
+        model = glm::translate(model, orbitPos);
         model = glm::rotate(model, glm::radians(20.0f * i) + time, glm::vec3(1.0f, 0.3f, 0.5f));
 
-        lightingShader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        if (indirect)
+        {
+            indirect->AddArrays(cubeVAO, 0, 36, model, &cubeMaterial);
+            continue;
+        }
+        renderQueue.AddArrays(RenderQueue::Opaque, lightingShader, cubeVAO, GL_TRIANGLES, 0, 36, model, &cubeMaterial);
     }
 }
 
@@ -115,6 +181,17 @@ int main()
     Shader lightCubeShader("6.light_cube.vs", "6.light_cube.fs");
     Shader backgroundShader("bg_light.vs", "bg_light.fs");
 
+    // on GL 4.3 contexts every cube goes out in one glMultiDrawArraysIndirect, its matrices in a
+    // storage buffer read by the _indirect vertex shader; otherwise one glDrawArrays per cube
+    IndirectDraw::Load((GLADloadproc)glfwGetProcAddress);
+    IndirectDraw* cubeIndirect = nullptr;
+    Shader* cubeIndirectShader = nullptr;
+    if (IndirectDraw::Supported())
+    {
+        cubeIndirect = new IndirectDraw();
+        cubeIndirectShader = new Shader("6.multiple_lights_indirect.vs", "6.multiple_lights.fs");
+    }
+
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
     float vertices[] = {
@@ -189,8 +266,7 @@ int main()
     glm::vec3 pointLightPositions[] = {
         glm::vec3( 0.7f,  0.2f,  10.0f),
         glm::vec3( 0.7f,  0.2f, -20.0f),
-        glm::vec3( 0.7f,  0.2f, -40.0f),
-        glm::vec3( 0.0f,  0.0f, -3.0f)
+        glm::vec3( 0.7f,  0.2f, -40.0f)
     };
     // first, configure the cube's VAO (and VBO)
     unsigned int VBO, cubeVAO;
@@ -252,8 +328,62 @@ int main()
     // shader configuration
     // --------------------
     lightingShader.use();
-    lightingShader.setInt("material.diffuse", 0);
-    lightingShader.setInt("material.specular", 1);
+    lightingShader.setFloat("material.shininess", 32.0f);
+    if (cubeIndirectShader)
+    {
+        cubeIndirectShader->use();
+        cubeIndirectShader->setFloat("material.shininess", 32.0f);
+    }
+    // both maps on the units MaterialBindings gives their sampler names, set on the program at the first draw
+    Material cubeMaterial;
+    cubeMaterial.Add("material.diffuse", diffuseMap);
+    cubeMaterial.Add("material.specular", specularMap);
+
+    // lights live in one uniform buffer, written again only when one of them changes
+    // -------------------------------------------------------------------------------
+    LightBuffer lights;
+    lights.Attach(lightingShader.ID);
+    if (cubeIndirectShader) lights.Attach(cubeIndirectShader->ID);
+    DirLight dirLight;
+    dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    dirLight.ambient = glm::vec3(0.05f);
+    dirLight.diffuse = glm::vec3(0.4f);
+    dirLight.specular = glm::vec3(0.5f);
+    lights.SetDirLight(dirLight);
+    // red glows, brighter the further away they are
+    const glm::vec3 pointLightColors[] = {
+        glm::vec3(3.0f, 0.3f, 0.3f),
+        glm::vec3(5.0f, 0.3f, 0.3f),
+        glm::vec3(10.0f, 0.3f, 0.3f)
+    };
+    const glm::vec3 pointLightAmbients[] = { glm::vec3(0.05f), glm::vec3(0.1f), glm::vec3(0.05f) };
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        PointLight light;
+        light.position = pointLightPositions[i];
+        light.ambient = pointLightAmbients[i];
+        light.diffuse = pointLightColors[i];
+        light.specular = pointLightColors[i];
+        light.constant = 1.0f;
+        light.linear = 0.014f;
+        light.quadratic = 0.0007f;
+        lights.AddPointLight(light);
+    }
+    // uniform buffer binding 0 is LightBuffer's
+    ClusteredLights glowLights(1);
+    glowLights.Attach(lightingShader.ID);
+    if (cubeIndirectShader) glowLights.Attach(cubeIndirectShader->ID);
+    lightingShader.use();
+    // the frame's draws, sorted by pass / program / material / vertex array / depth before they are sent
+    RenderQueue renderQueue;
+    // GPU time per frame measured with timer queries; when the cube sculpture gets too heavy the scene
+    // is drawn into a smaller target and a sharpening upscale stretches it over the window
+    DynamicResolution dynamicResolution(16.0f, 0.5f, 1.0f);
+    RenderGraph renderGraph;
+    Shader upscaleShader("post.vs", "upscale.fs");
+    GLuint upscaleUnit = MaterialBindings::UnitFor("sourceTexture");
+    upscaleShader.use();
+    upscaleShader.setFloat("sharpness", 0.5f);
 
 
     // render loop
@@ -272,182 +402,119 @@ int main()
 
         // render
         // ------
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        dynamicResolution.BeginFrame();
 
         // be sure to activate shader when setting uniforms/drawing objects
         lightingShader.use();
         lightingShader.setVec3("viewPos", camera.Position);
-        lightingShader.setFloat("material.shininess", 32.0f);
-
-        /*
-           Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-           the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-           by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-           by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-        */
-        // directional light
-        lightingShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        // point light 1 (testing)
-        lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[0].diffuse", 3.0f, 0.3f, 0.3f);   // brighter red glow
-        lightingShader.setVec3("pointLights[0].specular", 3.0f, 0.3f, 0.3f);  // stronger reflection
-        lightingShader.setFloat("pointLights[0].constant", 1.0f);
-        lightingShader.setFloat("pointLights[0].linear", 0.014f);
-        lightingShader.setFloat("pointLights[0].quadratic", 0.0007f);
-        // point light 2
-        lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-        lightingShader.setVec3("pointLights[1].ambient", 0.1f, 0.1f, 0.1f);
-        lightingShader.setVec3("pointLights[1].diffuse", 5.0f, 0.3f, 0.3f);
-        lightingShader.setVec3("pointLights[1].specular", 5.0f, 0.3f, 0.3f);
-        lightingShader.setFloat("pointLights[1].constant", 1.0f);
-        lightingShader.setFloat("pointLights[1].linear", 0.014f);
-        lightingShader.setFloat("pointLights[1].quadratic", 0.0007f);
-        // point light 3
-        lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-        lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[2].diffuse", 10.0f, 0.3f, 0.3f);
-        lightingShader.setVec3("pointLights[2].specular", 10.0f, 0.3f, 0.3f);
-        lightingShader.setFloat("pointLights[2].constant", 1.0f);
-        lightingShader.setFloat("pointLights[2].linear", 0.014f);
-        lightingShader.setFloat("pointLights[2].quadratic", 0.0007f);
-        // point light 4 (unused)
-        lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-        lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[3].constant", 1.0f);
-        lightingShader.setFloat("pointLights[3].linear", 0.09f);
-        lightingShader.setFloat("pointLights[3].quadratic", 0.032f);
-        // spotLight (unused)
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
-        lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09f);
-        lightingShader.setFloat("spotLight.quadratic", 0.032f);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));     
-
-        
+        lights.Upload(); // writes the buffer only if a light changed
 
         // view/projection transformations
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
         lightingShader.setMat4("projection", projection);
         lightingShader.setMat4("view", view);
-
-        // world transformation
-        glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
-
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        if (cubeIndirectShader)
+        {
+            cubeIndirectShader->use();
+            cubeIndirectShader->setVec3("viewPos", camera.Position);
+            cubeIndirectShader->setMat4("projection", projection);
+            cubeIndirectShader->setMat4("view", view);
+        }
+        viewFrustum.Update(projection * view);
+
+        // the glowing cubes, binned into clusters so each fragment only shades the ones near it
+        float time = static_cast<float>(glfwGetTime());
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glm::ivec2 renderSize = dynamicResolution.ScaledSize(framebufferWidth, framebufferHeight);
+        glowLights.Clear();
+        for (const OrbitRing& ring : orbitRings)
+            AddOrbitLights(glowLights, ring, time);
+        for (unsigned int i = 0; i < 10; i++)
+            glowLights.Add(FloatingCubePosition(cubePositions[i], i, time), glowRadius, glowColor);
+        glowLights.Update(view, projection, renderSize.x, renderSize.y); // clusters are looked up from gl_FragCoord
+        glowLights.Bind();
 
         // render containers
-        glBindVertexArray(cubeVAO);
-
-        float time = glfwGetTime();
-
-        DrawOrbitingCubes(lightingShader, glm::vec3(8.0f, 3.0f, -20.0f),
-            30.0f, 45.0f, 50, time * 0.10f,
-            glm::vec3(1.0f, 0.0f, 0.0f), 10.0f,   // tilt around X-axis
-            glm::vec3(0.0f, 1.0f, 0.0f), 55.0f); // rotate around Y-axis
-        
-        DrawOrbitingCubes(lightingShader, glm::vec3(3.0f, 3.0f, -25.0f),
-            30.0f, 50.0f, 45, time * 0.10f,
-            glm::vec3(1.0f, 0.0f, 0.0f), 20.0f,   // tilt around X-axis
-            glm::vec3(0.0f, 1.0f, 0.0f), 55.0f); // rotate around Y-axi
-
-        DrawOrbitingCubes(lightingShader, glm::vec3(-10.0f, 0.0f, -20.0f), 
-            40.0f, 45.0f, 40, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), 20.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -30.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-10.0f, 0.0f, -20.0f),
-            40.0f, 50.0f, 50, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), 20.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-15.0f, 0.0f, -30.0f),
-            45.0f, 25.0f, 50, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), 30.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-15.0f, 0.0f, -25.0f),
-            45.0f, 25.0f, 40, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), 30.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
-
-        //////////////////
-        DrawOrbitingCubes(lightingShader, glm::vec3(-10.0f, 0.0f, -20.0f),
-            40.0f, 50.0f, 40, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), -10.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -30.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-10.0f, 0.0f, -20.0f),
-            40.0f, 55.0f, 50, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), -10.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-15.0f, 0.0f, -30.0f),
-            45.0f, 30.0f, 50, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), -10.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
-        DrawOrbitingCubes(lightingShader, glm::vec3(-15.0f, 0.0f, -25.0f),
-            45.0f, 35.0f, 40, time,
-            glm::vec3(1.0f, 0.0f, 0.0f), -10.0f,
-            glm::vec3(0.0f, 1.0f, 0.0f), -40.0f);
+        renderQueue.Begin(view, 100.0f);
+        for (const OrbitRing& ring : orbitRings)
+            EnqueueOrbitingCubes(renderQueue, lightingShader, cubeVAO, cubeMaterial, ring, time, cubeIndirect);
 
         ///////////////////
         for (unsigned int i = 0; i < 10; i++)
         {
-            float floatY = sin(glfwGetTime() * 0.8f + i * 0.6f) * 0.5f;
+            glm::vec3 pos = FloatingCubePosition(cubePositions[i], i, time);
 
-            // base world position + floating offset
-            glm::vec3 pos = cubePositions[i];
-            pos.y += floatY;
+            if (!viewFrustum.Intersects(BoundingSphere(pos, cubeRadius)))
+                continue;
 
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, pos); // move to position first
 
             // now rotate around its *own center*
-            float angle = static_cast<float>(glfwGetTime()) * 25.0f;
+            float angle = time * 25.0f;
             model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
 
-            lightingShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            if (cubeIndirect)
+                cubeIndirect->AddArrays(cubeVAO, 0, 36, model, &cubeMaterial);
+            else
+                renderQueue.AddArrays(RenderQueue::Opaque, lightingShader, cubeVAO, GL_TRIANGLES, 0, 36, model, &cubeMaterial);
         }
+        if (cubeIndirect)
+            renderQueue.AddCustom(RenderQueue::Opaque, *cubeIndirectShader, camera.Position, [&]() { cubeIndirect->Submit(*cubeIndirectShader); });
         //////////////////
 
 
 
-        // bind the background shader
-        backgroundShader.use();
-        backgroundShader.setMat4("view", view);
-        backgroundShader.setMat4("projection", projection);
-        
-        model = glm::mat4(1.0f);
-
-        float scaleX = 51.0f; // base width in world units
-        float scaleY = 51.0f; // base height in world units
+        // the background quad, after the cubes so it only shades what they left uncovered
+        renderQueue.AddCustom(RenderQueue::Background, backgroundShader, glm::vec3(0.0f, 0.0f, -50.0f), [&]() {
+            backgroundShader.setMat4("view", view);
+            backgroundShader.setMat4("projection", projection);
 
-        float aspect = (float)textureWidth / (float)textureHeight;
-        model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -50.0f));
-        model = glm::scale(model, glm::vec3(aspect * scaleX, scaleY, 1.0f)); // scale the translated matrix
-        backgroundShader.setMat4("model", model);
-
-        glBindVertexArray(quadVAO);
+            glm::mat4 model = glm::mat4(1.0f);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, bg);
-        backgroundShader.setInt("screenTexture", 0);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            float scaleX = 51.0f; // base width in world units
+            float scaleY = 51.0f; // base height in world units
+
+            float aspect = (float)textureWidth / (float)textureHeight;
+            model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -50.0f));
+            model = glm::scale(model, glm::vec3(aspect * scaleX, scaleY, 1.0f)); // scale the translated matrix
+            backgroundShader.setMat4("model", model);
+
+            glBindVertexArray(quadVAO);
+
+            MaterialBindings::Invalidate(); // unit 0 active, cube material cache forgotten
+            glBindTexture(GL_TEXTURE_2D, bg);
+            backgroundShader.setInt("screenTexture", 0);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        });
+
+        // at full scale the scene goes straight to the window, otherwise into a smaller target first
+        renderGraph.Begin(framebufferWidth, framebufferHeight);
+        auto drawScene = [&]() {
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderQueue.Execute();
+        };
+        if (renderSize.x != framebufferWidth || renderSize.y != framebufferHeight)
+        {
+            RenderGraph::Resource sceneColor = renderGraph.Create("sceneColor", { renderSize.x, renderSize.y, GL_RGBA8 });
+            RenderGraph::Resource sceneDepth = renderGraph.Create("sceneDepth", { renderSize.x, renderSize.y, GL_DEPTH_COMPONENT24 });
+            renderGraph.AddPass("scene", {}, { sceneColor, sceneDepth }, drawScene);
+            renderGraph.AddPass("upscale", { sceneColor }, { RenderGraph::Backbuffer }, [&, sceneColor]() {
+                upscaleShader.use();
+                MaterialBindings::Prepare(upscaleShader.ID);
+                MaterialBindings::Bind(upscaleUnit, renderGraph.Texture(sceneColor));
+                renderGraph.DrawFullscreenTriangle();
+            });
+        }
+        else
+        {
+            renderGraph.AddPass("scene", {}, { RenderGraph::Backbuffer }, drawScene);
+        }
+        renderGraph.Execute();
+        dynamicResolution.EndFrame();
 
         ///////////////
          
@@ -463,6 +530,8 @@ int main()
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
+    delete cubeIndirect;
+    delete cubeIndirectShader;
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &lightCubeVAO);
     glDeleteBuffers(1, &VBO);
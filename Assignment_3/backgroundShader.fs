@@ -12,7 +12,7 @@ uniform vec3 objectColor;
 
 void main()
 {
-    // rim glow
+    // rim light as shading only: it stays under the bloom threshold, the glow is left to the bullets
     vec3 viewDir = normalize(viewPos - FragPos);
     float rim = 1.0 - max(dot(normalize(Normal), viewDir), 0.0);
     rim = pow(rim, 3.0);
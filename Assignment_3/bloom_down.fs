@@ -0,0 +1,32 @@
+#version 330 core
+// dual filter downsample (Bloom in bloom.h): 4x the center plus the 4 diagonal corners one source
+// texel away, each a bilinear tap over 4 texels
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D sourceTexture;
+uniform float threshold; // > 0 on the first level only: keep what is brighter than this
+uniform float knee;      // soft band below the threshold
+
+void main()
+{
+    vec2 offset = 1.0 / vec2(textureSize(sourceTexture, 0));
+    vec3 color = texture(sourceTexture, TexCoords).rgb * 4.0;
+    color += texture(sourceTexture, TexCoords - offset).rgb;
+    color += texture(sourceTexture, TexCoords + offset).rgb;
+    color += texture(sourceTexture, TexCoords + vec2(offset.x, -offset.y)).rgb;
+    color += texture(sourceTexture, TexCoords - vec2(offset.x, -offset.y)).rgb;
+    color *= 0.125;
+
+    if (threshold > 0.0)
+    {
+        // quadratic curve from threshold - knee up to threshold + knee, linear above
+        float brightness = max(color.r, max(color.g, color.b));
+        float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+        soft = soft * soft / (4.0 * knee + 1e-4);
+        color *= max(soft, brightness - threshold) / max(brightness, 1e-4);
+        color = min(color, vec3(64.0)); // a single very bright specular pixel must not flash the screen
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -32,21 +32,14 @@ void main()
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16);
     vec3 specular = specularStrength * spec * lightColor;
 
-    // Emission
+    // Emission, written as is into the HDR target: the halo comes from the bloom pass
     vec3 emission = emissionColor * emissionStrength;
 
-    float rim = 1.0 - max(dot(norm, viewDir), 0.0);
-    rim = pow(rim, 1.0);     // almost linear very wide halo
-    rim = clamp(rim, 0.0, 1.0);
-
-    vec3 rimGlow = emissionColor * rim * (emissionStrength * 10.0);
-
     // Final output
     vec3 result = ambient * objectColor
                 + diffuse * objectColor
                 + specular
-                + emission
-                + rimGlow;   // outer halo
+                + emission;
 
     FragColor = vec4(result, 1.0);
 }
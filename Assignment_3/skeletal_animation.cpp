@@ -10,6 +10,10 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/bloom.h>
+#include <learnopengl/dynamic_resolution.h>
 
 
 
@@ -61,6 +65,9 @@ float lastFrame = 0.0f;
 float playerRadius = 0.2f;   // approximate player hitbox
 float bulletRadius = 0.1f;   // your bullet scale
 
+// culling
+float minBulletPixels = 1.0f; // bullets smaller than this on screen are not drawn
+
 
 
 struct Bullet {
@@ -74,6 +81,8 @@ struct Bullet {
 	float orbitSpeed;        // radians/sec
 	int orbitDirection;      // 1 = clockwise, -1 = counterclockwise
 	glm::vec3 spawnCenter;   // center around which it rotates
+
+	int lod = 0;             // detail level drawn last frame
 };
 
 std::vector<Bullet> bullets;
@@ -128,20 +137,42 @@ int main()
 	// build and compile shaders
 	// -------------------------
 	Shader ourShader("anim_model.vs", "anim_model.fs");
+	GLint bonePaletteLocation = glGetUniformLocation(ourShader.ID, "finalBonesMatrices");
+	std::vector<glm::mat4> bonePalette;
 	Shader bulletShader("orbShader.vs", "orbShader.fs");
 	Shader backgroundShader("backgroundShader.vs", "backgroundShader.fs");
 	Shader picShader("bg_light.vs", "bg_light.fs");
+	// the frame's draws, sorted by pass / program / material / vertex array / depth before they are sent
+	RenderQueue renderQueue;
+	// the scene goes into an HDR target, bullets brighter than 1 glow through a half resolution bloom
+	RenderGraph renderGraph;
+	Shader presentShader("post.vs", "present.fs");
+	GLuint presentUnit = MaterialBindings::UnitFor("sourceTexture");
+	GLuint presentBloomUnit = MaterialBindings::UnitFor("bloomTexture");
+	presentShader.use();
+	presentShader.setFloat("bloomIntensity", 0.8f);
+	presentShader.setFloat("exposure", 1.5f);
+	Shader bloomDownShader("post.vs", "bloom_down.fs");
+	Shader bloomUpShader("post.vs", "bloom_up.fs");
+	Bloom bloom(bloomDownShader.ID, bloomUpShader.ID);
+	// GPU time per frame measured with timer queries; dense bullet rings lower the render scale
+	// instead of the frame rate, a sharpening upscale stretches the frame back over the window
+	DynamicResolution dynamicResolution(16.0f, 0.5f, 1.0f);
+	Shader upscaleShader("post.vs", "upscale.fs");
+	upscaleShader.use();
+	upscaleShader.setFloat("sharpness", 0.5f);
 
 	
 	// load models
 	// -----------
-	Model ourModel(FileSystem::getPath("resources/objects/goth_katana/goth_katana.dae"));
+	Model ourModel(FileSystem::getPath("resources/objects/goth_katana/goth_katana.dae"), false, VertexAttribsOf(ourShader));
 	Animation danceAnimation(FileSystem::getPath("resources/objects//goth_katana/goth_katana.dae"),&ourModel);
 	Animator animator(&danceAnimation);
 
-	Model bulletModel(FileSystem::getPath("resources/objects/bullets/blue_orb/blue_orb.obj"));
+	Model bulletModel(FileSystem::getPath("resources/objects/bullets/blue_orb/blue_orb.obj"), false, VertexAttribsOf(bulletShader), { 0.5f, 0.25f, 0.1f });
 
-	Model background(FileSystem::getPath("resources/objects/vaporwave_bg/vaporwave_bg.obj"));
+	Model background(FileSystem::getPath("resources/objects/vaporwave_bg/vaporwave_bg.obj"), false, VertexAttribsOf(backgroundShader));
+	background.BatchStaticMeshes(); // the scenery never moves apart, one draw per texture set
 
 	stbi_set_flip_vertically_on_load(true);
 	unsigned int bg = loadTexture(FileSystem::getPath("resources/textures/space.jpg").c_str());
@@ -231,14 +262,16 @@ int main()
 
 		// render
 		// ------
-		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
+		dynamicResolution.BeginFrame();
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		glm::ivec2 renderSize = dynamicResolution.ScaledSize(framebufferWidth, framebufferHeight);
 
 		//////////////////////////// BACKGROUND
 		// --- render background first ---
 		backgroundShader.use();
 		backgroundShader.setVec3("viewPos", camera.Position);
+		backgroundShader.setVec3("objectColor", glm::vec3(0.1f, 0.1f, 0.1f)); // dark gray
 		backgroundShader.setFloat("emissionStrength", 1.0f);
 
 		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
@@ -246,15 +279,12 @@ int main()
 		glm::mat4 bgModel = glm::mat4(1.0f);
 		bgModel = glm::translate(bgModel, glm::vec3(0.0f, -10.0f, -10.0f));
 		bgModel = glm::scale(bgModel, glm::vec3(0.1f)); // shrink a lot
-		backgroundShader.setMat4("model", bgModel);
 		backgroundShader.setMat4("view", camera.GetViewMatrix());
 		backgroundShader.setMat4("projection", projection);
-		for (unsigned int i = 0; i < background.meshes.size(); i++)
-		{
-			backgroundShader.setVec3("objectColor", glm::vec3(0.1f, 0.1f, 0.1f)); // dark gray
-			backgroundShader.setFloat("emissionStrength", 1.0f);
-			background.meshes[i].Draw(backgroundShader);
-		}
+		Frustum frustum(projection * view);
+		// everything below is queued and sent sorted by state and front to back at the end of the frame
+		renderQueue.Begin(view, 100.0f);
+		background.Enqueue(renderQueue, RenderQueue::Opaque, backgroundShader, bgModel, 0, &frustum);
 
 
 
@@ -269,7 +299,7 @@ int main()
 
 		// Glow settings (BLUE glow)
 		bulletShader.setVec3("emissionColor", glm::vec3(0.2f, 0.5f, 1.0f)); // blue
-		bulletShader.setFloat("emissionStrength", 1.2f); // bump this for more glow
+		bulletShader.setFloat("emissionStrength", 3.0f); // the part over 1 blooms, bump this for more glow
 
 
 		// view/projection transformations
@@ -365,8 +395,14 @@ int main()
 			bulletMat = glm::translate(bulletMat, b.position);
 			bulletMat = glm::scale(bulletMat, glm::vec3(0.1f));
 
-			bulletShader.setMat4("model", bulletMat);
-			bulletModel.Draw(bulletShader);
+			// drop bullets outside the view or too far away to cover a pixel
+			BoundingSphere bounds = bulletModel.sphere.Transformed(bulletMat);
+			if (!frustum.Intersects(bounds) ||
+				ProjectedRadius(bounds, camera.Position, projection, (float)renderSize.y) < minBulletPixels)
+				continue;
+
+			b.lod = bulletModel.SelectLod(bulletMat, camera.Position, projection, (float)renderSize.y, b.lod);
+			bulletModel.Enqueue(renderQueue, RenderQueue::Opaque, bulletShader, bulletMat, b.lod);
 		}
 
 		///////////////
@@ -382,9 +418,7 @@ int main()
 		ourShader.setMat4("view", view);
 
 
-		auto transforms = animator.GetFinalBoneMatrices();
-		for (int i = 0; i < transforms.size(); ++i)
-			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+		const auto& transforms = animator.GetFinalBoneMatrices();
 		
 		// render the loaded model
 		glm::mat4 model = glm::mat4(1.0f);
@@ -393,32 +427,69 @@ int main()
 		model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(.5f, .5f, .5f));	// it's a bit too big for our scene, so scale it down
-		ourShader.setMat4("model", model);
-		ourModel.Draw(ourShader);
+		// vertex bone ids index each mesh's own palette (Mesh::boneRemap), so upload per mesh
+		renderQueue.AddCustom(RenderQueue::Opaque, ourShader, modelPosition, [&, model]() {
+			ourShader.setMat4("model", model);
+			for (Mesh& mesh : ourModel.meshes)
+			{
+				mesh.UploadBonePalette(bonePaletteLocation, transforms, bonePalette);
+				mesh.Draw(ourShader);
+			}
+		});
 
 
 		//////////////////PICS
-		// bind the background shader
-		picShader.use();
-		picShader.setMat4("view", view);
-		picShader.setMat4("projection", projection);
-
-		model = glm::mat4(1.0f);
-
-		float scaleX = 100.0f; // base width in world units
-		float scaleY = 100.0f; // base height in world units
-
-		float aspect = (float)textureWidth / (float)textureHeight;
-		model = glm::translate(glm::mat4(1.0f), modelPosition + glm::vec3(0.0f, 0.0f, -70.0f));
-		model = glm::scale(model, glm::vec3(aspect * scaleX, scaleY, 4.0f));
-		picShader.setMat4("model", model);
-
-		glBindVertexArray(quadVAO);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, bg);
-		picShader.setInt("screenTexture", 0);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		// the space picture, once the depth buffer holds everything in front of it
+		renderQueue.AddCustom(RenderQueue::Background, picShader, modelPosition + glm::vec3(0.0f, 0.0f, -70.0f), [&]() {
+			picShader.setMat4("view", view);
+			picShader.setMat4("projection", projection);
+
+			float scaleX = 100.0f; // base width in world units
+			float scaleY = 100.0f; // base height in world units
+
+			float aspect = (float)textureWidth / (float)textureHeight;
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), modelPosition + glm::vec3(0.0f, 0.0f, -70.0f));
+			model = glm::scale(model, glm::vec3(aspect * scaleX, scaleY, 4.0f));
+			picShader.setMat4("model", model);
+
+			glBindVertexArray(quadVAO);
+
+			MaterialBindings::Invalidate(); // unit 0 active, mesh texture cache forgotten
+			glBindTexture(GL_TEXTURE_2D, bg);
+			picShader.setInt("screenTexture", 0);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+
+		renderGraph.Begin(framebufferWidth, framebufferHeight);
+		RenderGraph::Resource sceneColor = renderGraph.Create("sceneColor", { renderSize.x, renderSize.y, GL_RGBA16F });
+		RenderGraph::Resource sceneDepth = renderGraph.Create("sceneDepth", { renderSize.x, renderSize.y, GL_DEPTH_COMPONENT24 });
+		renderGraph.AddPass("scene", {}, { sceneColor, sceneDepth }, [&]() {
+			glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			renderQueue.Execute();
+		});
+		RenderGraph::Resource sceneBloom = bloom.AddPasses(renderGraph, sceneColor);
+		// at a reduced scale the composed frame stays at the render size and is upscaled to the window
+		bool upscale = renderSize.x != framebufferWidth || renderSize.y != framebufferHeight;
+		RenderGraph::Resource frame = upscale ? renderGraph.Create("frame", { renderSize.x, renderSize.y, GL_RGBA8 }) : RenderGraph::Backbuffer;
+		renderGraph.AddPass("present", { sceneColor, sceneBloom }, { frame }, [&]() {
+			presentShader.use();
+			MaterialBindings::Prepare(presentShader.ID);
+			MaterialBindings::Bind(presentUnit, renderGraph.Texture(sceneColor));
+			MaterialBindings::Bind(presentBloomUnit, renderGraph.Texture(sceneBloom));
+			renderGraph.DrawFullscreenTriangle();
+		});
+		if (upscale)
+		{
+			renderGraph.AddPass("upscale", { frame }, { RenderGraph::Backbuffer }, [&]() {
+				upscaleShader.use();
+				MaterialBindings::Prepare(upscaleShader.ID);
+				MaterialBindings::Bind(presentUnit, renderGraph.Texture(frame));
+				renderGraph.DrawFullscreenTriangle();
+			});
+		}
+		renderGraph.Execute();
+		dynamicResolution.EndFrame();
 
 
 
@@ -501,6 +572,7 @@ unsigned int loadTexture(char const* path)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
+		MaterialBindings::Invalidate();
 		glBindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
@@ -9,6 +9,7 @@
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 #include <learnopengl/animation.h>
+#include <learnopengl/frustum.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -122,6 +123,12 @@ int main() {
     glEnable(GL_DEPTH_TEST);
 
     Shader ourShader("anim_model.vs", "anim_model.fs");
+    // skinned meshes index a per-mesh bone palette (Mesh::boneRemap), uploaded before each one draws
+    GLint bonePaletteLocation = glGetUniformLocation(ourShader.ID, "finalBonesMatrices");
+    std::vector<glm::mat4> bonePalette;
+    // static meshes (katana, stones, forest) upload no bone weights, so attribute 6 reads the current
+    // generic value; zero weights keep them unskinned instead of the default (0,0,0,1) moving them with bone 1
+    glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
     Shader picShader("bg_light.vs", "bg_light.fs");
 
     // Resource paths
@@ -332,10 +339,7 @@ int main() {
         glm::mat4 view = camera.GetViewMatrix();
         ourShader.setMat4("projection", projection);
         ourShader.setMat4("view", view);
-
-        auto transforms = animator.GetFinalBoneMatrices();
-        for (int i = 0; i < (int)transforms.size(); ++i)
-            ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+        Frustum frustum(projection * view);
 
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(scenePosX, -0.4f, 0.0f));
@@ -343,7 +347,11 @@ int main() {
         model = glm::scale(model, glm::vec3(0.5f));
         ourShader.setMat4("model", model);
 
-        ourModel.Draw(ourShader);
+        auto transforms = animator.GetFinalBoneMatrices();
+        for (Mesh& mesh : ourModel.meshes) {
+            mesh.UploadBonePalette(bonePaletteLocation, transforms, bonePalette);
+            mesh.Draw(ourShader);
+        }
 
         if (katana && charState == SLASH) { // Only draw katana while slashing
             glm::mat4 boneMat = GetBoneMatrix(ourModel, animator, handBone);
@@ -366,6 +374,11 @@ int main() {
                 glm::mat4 stoneModel = glm::mat4(1.0f);
                 stoneModel = glm::translate(stoneModel, glm::vec3(stoneX, 0.0f, 0.0f));
                 stoneModel = glm::scale(stoneModel, glm::vec3(0.5f)); // Set scale as needed
+
+                // Off-screen stones are dropped here, before any uniform or draw
+                if (!frustum.Intersects(stone->aabb.Transformed(stoneModel)))
+                    continue;
+
                 ourShader.setMat4("model", stoneModel);
                 stone->Draw(ourShader);
             }
@@ -377,8 +390,10 @@ int main() {
             forestModel = glm::scale(forestModel, glm::vec3(0.1f, 1.0f, 0.1f));
             forestModel = glm::rotate(forestModel, glm::radians(180.0f), glm::vec3(1, 0, 0));
             forestModel = glm::rotate(forestModel, glm::radians(45.0f), glm::vec3(0, 1, 0));  // 4. Translate last
-            ourShader.setMat4("model", forestModel);
-            forest->Draw(ourShader);
+            if (frustum.Intersects(forest->aabb.Transformed(forestModel))) {
+                ourShader.setMat4("model", forestModel);
+                forest->Draw(ourShader, frustum, forestModel); // per-mesh culling inside
+            }
         }
 
         //////////////////PICS
@@ -6,15 +6,108 @@ in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
 
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray texture_array; // every diffuse texture of the model, see Model::BuildTextureArray
+flat in uint Layer;
+#else
 uniform sampler2D texture_diffuse1;
+#endif
 uniform float alphaCutoff; // discard fragments below this
+uniform float dissolve;    // share of pixels handed over to an impostor (see impostor.fs), 0 = solid
+
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
+
+#ifdef LIGHT_PROBE
+// diffuse light at the object from the baked probes (and nearby orbs), L2 SH already convolved and
+// divided by pi on the CPU (LightProbeGrid in light_probes.h)
+uniform vec3 shIrradiance[9];
+
+vec3 ProbeLighting(vec3 n)
+{
+    vec3 result = shIrradiance[0] * 0.282095
+        + shIrradiance[1] * (0.488603 * n.y)
+        + shIrradiance[2] * (0.488603 * n.z)
+        + shIrradiance[3] * (0.488603 * n.x)
+        + shIrradiance[4] * (1.092548 * n.x * n.y)
+        + shIrradiance[5] * (1.092548 * n.y * n.z)
+        + shIrradiance[6] * (0.315392 * (3.0 * n.z * n.z - 1.0))
+        + shIrradiance[7] * (1.092548 * n.x * n.z)
+        + shIrradiance[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(result, vec3(0.0));
+}
+#endif
+
+// sun shadows: a cached map of the static casters and a per-frame one around the player
+// (ShadowMaps in shadow_maps.h), matrices are light projection * light view
+layout(std140) uniform ShadowBlock {
+    mat4 staticLightSpace;
+    mat4 dynamicLightSpace;
+    vec4 shadowParams; // x / y: normal offset of the static / dynamic map in world units, z: strength
+};
+uniform sampler2DShadow staticShadowMap;
+uniform sampler2DShadow dynamicShadowMap;
+
+// 4 hardware 2x2 PCF taps, 1 outside the map
+float ShadowMapVisibility(sampler2DShadow shadowMap, mat4 lightSpace, vec3 position)
+{
+    vec3 coord = vec3(lightSpace * vec4(position, 1.0)) * 0.5 + 0.5;
+    if (any(lessThan(coord, vec3(0.0))) || any(greaterThan(coord, vec3(1.0))))
+        return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = texture(shadowMap, vec3(coord.xy + vec2(-0.5, -0.5) * texel, coord.z))
+        + texture(shadowMap, vec3(coord.xy + vec2(0.5, -0.5) * texel, coord.z))
+        + texture(shadowMap, vec3(coord.xy + vec2(-0.5, 0.5) * texel, coord.z))
+        + texture(shadowMap, vec3(coord.xy + vec2(0.5, 0.5) * texel, coord.z));
+    return lit * 0.25;
+}
+
+// share of the sun light left at the fragment, the receiver is pushed out along its normal against acne
+float ShadowVisibility(vec3 fragPos, vec3 normal)
+{
+    float visibility = min(ShadowMapVisibility(staticShadowMap, staticLightSpace, fragPos + normal * shadowParams.x),
+        ShadowMapVisibility(dynamicShadowMap, dynamicLightSpace, fragPos + normal * shadowParams.y));
+    return 1.0 - shadowParams.z * (1.0 - visibility);
+}
+
+#include "clustered_lighting.glsl"
+
+// 4x4 ordered dither, same pattern as impostor.fs so the two fades never overlap
+float ditherThreshold()
+{
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+    return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
 
 void main()
 {
+#ifdef TEXTURE_ARRAY
+    vec4 tex = texture(texture_array, vec3(TexCoords, float(Layer)));
+#else
     vec4 tex = texture(texture_diffuse1, TexCoords);
+#endif
 
     if (tex.a < alphaCutoff)
         discard;
+    if (ditherThreshold() < dissolve)
+        discard;
 
-    FragColor = tex;
+    vec3 normal = normalize(Normal);
+    float sun = ShadowVisibility(FragPos, normal);
+#ifdef LIGHT_PROBE
+    // a handful of uniforms instead of a light loop on every skinned pixel
+    FragColor = vec4(tex.rgb * ProbeLighting(normal) * sun, tex.a);
+#else
+    // the textures carry the base (sun) lighting, point lights (orbs) are added on top and cast no shadows
+    vec3 clusterDiffuse, clusterSpecular;
+    ClusteredLighting(FragPos, normal, normalize(viewPos.xyz - FragPos), 32.0, clusterDiffuse, clusterSpecular);
+    FragColor = vec4(tex.rgb * (sun + clusterDiffuse) + 0.25 * clusterSpecular, tex.a);
+#endif
 }
\ No newline at end of file
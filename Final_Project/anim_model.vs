@@ -1,20 +1,59 @@
 #version 330 core
 
+// Compiled per variant by SkinningShaders: SKIN_INFLUENCES is 0 for static meshes,
+// otherwise how many bone slots each vertex reads (1, 2 or 4).
+// Bone ids index the mesh's own palette, weights arrive sorted and normalized,
+// and unused slots are id 0 / weight 0, so skinning is a plain weighted sum.
+#ifndef SKIN_INFLUENCES
+#define SKIN_INFLUENCES 4
+#endif
+#ifndef MAX_MESH_BONES
+#define MAX_MESH_BONES 64
+#endif
+// INDIRECT_DRAW (static variant, GL 4.3 contexts): model / normal matrix come from the IndirectDraw
+// storage buffer, indexed by the per-draw id attribute instead of uniforms
+#ifdef INDIRECT_DRAW
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+// TEXTURE_ARRAY: meshes merged by Model::BuildTextureArray, each vertex carries its texture layer
+
 layout(location = 0) in vec3 pos;
 layout(location = 1) in vec3 norm;
 layout(location = 2) in vec2 tex;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
+layout(location = 3) in vec4 tangent; // w = bitangent sign, bitangent = cross(norm, tangent.xyz) * tangent.w
+#if SKIN_INFLUENCES > 0
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
+#endif
+#ifdef TEXTURE_ARRAY
+layout(location = 8) in uint layer;
+flat out uint Layer;
+#endif
 
-uniform mat4 projection;
-uniform mat4 view;
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
+#ifdef INDIRECT_DRAW
+layout(location = 7) in uint drawIndex;
+struct DrawData {
+    mat4 model;
+    mat4 normalMatrix;
+};
+layout(std430) readonly buffer DrawBlock {
+    DrawData draws[];
+};
+#else
 uniform mat4 model;
+uniform mat3 normalMatrix; // transpose(inverse(model)), computed on the CPU
+#endif
 
-const int MAX_BONES = 100;
-const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+#if SKIN_INFLUENCES > 0
+uniform mat4 finalBonesMatrices[MAX_MESH_BONES];
+#endif
 
 out vec2 TexCoords;
 out vec3 FragPos;
@@ -22,44 +61,32 @@ out vec3 Normal;
 
 void main()
 {
-    vec4 skinnedPos = vec4(0.0);
-    vec3 skinnedNormal = vec3(0.0);
-    float totalWeight = 0.0;
-
-    for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
-    {
-        int id = boneIds[i];
-        float w = weights[i];
-        if (w <= 0.0 || id < 0) continue;
-
-        if (id >= MAX_BONES)
-        {
-            skinnedPos = vec4(pos, 1.0);
-            skinnedNormal = norm;
-            totalWeight = 1.0;
-            break;
-        }
-
-        mat4 boneMat = finalBonesMatrices[id];
-        skinnedPos += boneMat * vec4(pos, 1.0) * w;
-        skinnedNormal += mat3(boneMat) * norm * w;
-        totalWeight += w;
-    }
+#ifdef INDIRECT_DRAW
+    mat4 model = draws[drawIndex].model;
+    mat3 normalMatrix = mat3(draws[drawIndex].normalMatrix);
+#endif
+    vec4 skinnedPos = vec4(pos, 1.0);
+    vec3 skinnedNormal = norm;
 
-    if (totalWeight <= 0.0)
-    {
-        skinnedPos = vec4(pos, 1.0);
-        skinnedNormal = norm;
-    }
-    else if (abs(totalWeight - 1.0) > 1e-5)
-    {
-        skinnedPos /= totalWeight;
-        skinnedNormal /= totalWeight;
-    }
+#if SKIN_INFLUENCES > 0
+    mat4 skin = finalBonesMatrices[boneIds.x] * weights.x;
+#if SKIN_INFLUENCES > 1
+    skin += finalBonesMatrices[boneIds.y] * weights.y;
+#endif
+#if SKIN_INFLUENCES > 2
+    skin += finalBonesMatrices[boneIds.z] * weights.z;
+    skin += finalBonesMatrices[boneIds.w] * weights.w;
+#endif
+    skinnedPos = skin * vec4(pos, 1.0);
+    skinnedNormal = mat3(skin) * norm;
+#endif
 
     gl_Position = projection * view * model * skinnedPos;
 
     TexCoords = tex;
+#ifdef TEXTURE_ARRAY
+    Layer = layer;
+#endif
     FragPos = vec3(model * skinnedPos);
-    Normal = normalize(mat3(transpose(inverse(model))) * skinnedNormal);
-}
\ No newline at end of file
+    Normal = normalize(normalMatrix * skinnedNormal);
+}
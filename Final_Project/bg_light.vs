@@ -5,8 +5,13 @@ layout (location = 1) in vec2 aTexCoords;
 out vec2 TexCoords; // send to FS
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
 
 void main()
 {
@@ -0,0 +1,21 @@
+#version 330 core
+// dual filter upsample (Bloom in bloom.h): a ring of 8 bilinear taps, the diagonal ones weighted double
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D sourceTexture;
+
+void main()
+{
+    vec2 offset = 0.5 / vec2(textureSize(sourceTexture, 0));
+    vec3 color = texture(sourceTexture, TexCoords + vec2(-offset.x * 2.0, 0.0)).rgb;
+    color += texture(sourceTexture, TexCoords + vec2(offset.x * 2.0, 0.0)).rgb;
+    color += texture(sourceTexture, TexCoords + vec2(0.0, -offset.y * 2.0)).rgb;
+    color += texture(sourceTexture, TexCoords + vec2(0.0, offset.y * 2.0)).rgb;
+    color += texture(sourceTexture, TexCoords + vec2(-offset.x, offset.y)).rgb * 2.0;
+    color += texture(sourceTexture, TexCoords + vec2(offset.x, offset.y)).rgb * 2.0;
+    color += texture(sourceTexture, TexCoords + vec2(offset.x, -offset.y)).rgb * 2.0;
+    color += texture(sourceTexture, TexCoords + vec2(-offset.x, -offset.y)).rgb * 2.0;
+    FragColor = vec4(color / 12.0, 1.0);
+}
@@ -0,0 +1,37 @@
+// Clustered point lights, binned on the CPU by ClusteredLights (clustered_lights.h).
+// Fragment stages pull this in with #include "clustered_lighting.glsl" (expanded by shader.h).
+// Assignment_2/6.multiple_lights.fs carries a copy of it, since shader_m.h has no #include.
+layout(std140) uniform ClusterBlock {
+    vec4 clusterDepthRow; // dot with (worldPos, 1) = view depth
+    vec4 clusterScale;    // xy: tiles per pixel, z / w: slice = log(depth) * z + w
+    ivec4 clusterGrid;    // tiles x, tiles y, slices, light count
+};
+uniform samplerBuffer clusterLights;   // 2 texels per light: position + radius, color
+uniform usamplerBuffer clusterRanges;  // per cluster: first entry in clusterIndices, light count
+uniform usamplerBuffer clusterIndices;
+
+// diffuse and specular light of the lights in this fragment's cluster (windowed inverse-square falloff)
+void ClusteredLighting(vec3 fragPos, vec3 normal, vec3 viewDir, float shininess, out vec3 diffuse, out vec3 specular)
+{
+    diffuse = vec3(0.0);
+    specular = vec3(0.0);
+    float depth = max(dot(clusterDepthRow, vec4(fragPos, 1.0)), 1e-4);
+    ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * clusterScale.xy), int(floor(log(depth) * clusterScale.z + clusterScale.w)));
+    cell = clamp(cell, ivec3(0), clusterGrid.xyz - 1);
+    uvec2 range = texelFetch(clusterRanges, (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x).xy;
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(clusterLights, light * 2);
+        vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w)
+            continue;
+        vec3 lightDir = toLight / distance;
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        diffuse += color * max(dot(normal, lightDir), 0.0) * attenuation;
+        specular += color * pow(max(dot(viewDir, reflect(-lightDir, normal)), 0.0), shininess) * attenuation;
+    }
+}
@@ -24,10 +24,9 @@ public:
 		m_CurrentAnimation2 = NULL;
 		m_blendAmount = 0;
 
-		m_FinalBoneMatrices.reserve(100);
-
-		for (int i = 0; i < 100; i++)
-			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+		// one matrix per bone the rig actually has, no fixed 100 bone limit
+		size_t boneCount = animation ? animation->GetBoneIDMap().size() : 100;
+		m_FinalBoneMatrices.assign(boneCount, glm::mat4(1.0f));
 	}
 
 	void UpdateAnimation(float dt, const std::vector<std::string>& frozenBones = {})
@@ -69,6 +68,12 @@ public:
 		m_blendAmount = blend;
 	}
 
+	// cross fade of 2 clips without a lower body layer (the Assignment 4 calls)
+	void PlayAnimation(Animation* pAnimation, Animation* pAnimation2, float time1, float time2, float blend)
+	{
+		PlayAnimation(pAnimation, pAnimation2, nullptr, time1, time2, 0.0f, blend);
+	}
+
 	glm::mat4 UpdateBlend(Bone* Bone1, Bone* Bone2) {
 		glm::vec3 bonePos1, bonePos2, finalPos;
 		glm::vec3 boneScale1, boneScale2, finalScale;
@@ -106,7 +111,7 @@ public:
 		Bone* Bone2 = m_CurrentAnimation2 ? m_CurrentAnimation2->FindBone(nodeName) : nullptr;
 
 		Bone* lowerBone = m_lowerAnimation ? m_lowerAnimation->FindBone(nodeName) : nullptr;
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
+		const auto& boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
 
 		bool isFrozen = std::find(frozenBones.begin(), frozenBones.end(), nodeName) != frozenBones.end();
 
@@ -136,10 +141,13 @@ public:
 
 		glm::mat4 globalTransformation = parentTransform * nodeTransform;
 
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+		auto boneInfo = boneInfoMap.find(nodeName);
+		if (boneInfo != boneInfoMap.end())
 		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
+			int index = boneInfo->second.id;
+			glm::mat4 offset = boneInfo->second.offset;
+			if (index >= (int)m_FinalBoneMatrices.size())
+				m_FinalBoneMatrices.resize(index + 1, glm::mat4(1.0f));
 			m_FinalBoneMatrices[index] = globalTransformation * offset;
 		}
 
@@ -150,7 +158,7 @@ public:
 
 
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
 		return m_FinalBoneMatrices;
 	}
@@ -0,0 +1,84 @@
+// Bloom for an HDR scene as RenderGraph passes (dual filter / dual Kawase).
+// The first pass thresholds the scene (soft knee, only what is brighter than 1 glows) while it
+// downsamples it to half resolution, the next ones halve it again down a short mip chain, then the
+// chain is upsampled back to half resolution. Each step is one small filter: 5 bilinear taps down,
+// 8 up (bloom_down.fs / bloom_up.fs with post.vs). The cost only depends on the screen size, not on
+// how many glowing objects there are, and the upsampled levels alias the downsampled ones of the
+// same size in the graph's pool.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <learnopengl/material.h>
+#include <learnopengl/render_graph.h>
+
+class Bloom
+{
+public:
+	float threshold = 1.0f; // brightness where the glow starts
+	float knee = 0.5f;      // soft band below the threshold
+
+	// downProgram / upProgram: post.vs with bloom_down.fs / bloom_up.fs; levels: 1 = half resolution only
+	Bloom(GLuint downProgram, GLuint upProgram, int levels = 5)
+		: m_Down(downProgram), m_Up(upProgram), m_Levels(std::max(levels, 1)),
+		m_Unit(MaterialBindings::UnitFor("sourceTexture"))
+	{
+		m_ThresholdLocation = glGetUniformLocation(m_Down, "threshold");
+		m_KneeLocation = glGetUniformLocation(m_Down, "knee");
+	}
+
+	// Adds the passes reading scene (an HDR color target) and returns the half resolution glow
+	RenderGraph::Resource AddPasses(RenderGraph& graph, RenderGraph::Resource scene)
+	{
+		const RenderGraph::TextureDesc& sceneDesc = graph.Desc(scene);
+		std::vector<RenderGraph::Resource> chain;
+		RenderGraph::Resource source = scene;
+		int width = sceneDesc.width, height = sceneDesc.height;
+		for (int level = 0; level < m_Levels; level++)
+		{
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			RenderGraph::Resource target = graph.Create("bloomDown" + std::to_string(level), { width, height, kFormat });
+			bool prefilter = level == 0;
+			graph.AddPass("bloomDown" + std::to_string(level), { source }, { target }, [this, &graph, source, prefilter]() {
+				glUseProgram(m_Down);
+				glUniform1f(m_ThresholdLocation, prefilter ? threshold : 0.0f);
+				glUniform1f(m_KneeLocation, knee);
+				draw(graph, m_Down, source);
+			});
+			chain.push_back(target);
+			source = target;
+		}
+		for (int level = m_Levels - 2; level >= 0; level--)
+		{
+			const RenderGraph::TextureDesc& desc = graph.Desc(chain[level]);
+			RenderGraph::Resource target = graph.Create("bloomUp" + std::to_string(level), { desc.width, desc.height, kFormat });
+			graph.AddPass("bloomUp" + std::to_string(level), { source }, { target }, [this, &graph, source]() {
+				glUseProgram(m_Up);
+				draw(graph, m_Up, source);
+			});
+			source = target;
+		}
+		return source;
+	}
+
+private:
+	static const GLenum kFormat = GL_R11F_G11F_B10F; // 4 bytes a texel, no alpha needed
+
+	GLuint m_Down;
+	GLuint m_Up;
+	int m_Levels;
+	GLuint m_Unit;
+	GLint m_ThresholdLocation;
+	GLint m_KneeLocation;
+
+	void draw(RenderGraph& graph, GLuint program, RenderGraph::Resource source)
+	{
+		MaterialBindings::Prepare(program);
+		MaterialBindings::Bind(m_Unit, graph.Texture(source));
+		graph.DrawFullscreenTriangle();
+	}
+};
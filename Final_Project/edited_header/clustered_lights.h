@@ -0,0 +1,236 @@
+// Clustered forward lighting for many small point lights (orbs, glowing cubes).
+// The view frustum is cut into kTilesX x kTilesY screen tiles and kSlices depth slices (exponential,
+// near to far). Every frame Update() bins the lights into the clusters their bounding sphere touches
+// and uploads three buffer textures; a fragment shader looks up its own cluster from gl_FragCoord and
+// its depth and only loops over the lights listed there, so shading cost follows the local light
+// count instead of the total.
+// Buffer textures and a uniform block keep it on GL 3.3. Shaders get the ClusterBlock block, the
+// three samplers and ClusteredLighting() from clustered_lighting.glsl; every such program has to be
+// Attach()ed before it draws, since its buffer samplers must not be left on unit 0.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <learnopengl/material.h>
+
+class ClusteredLights
+{
+public:
+	static const int kTilesX = 16;
+	static const int kTilesY = 9;
+	static const int kSlices = 24;
+	static const int kClusters = kTilesX * kTilesY * kSlices;
+
+	// blockBinding: uniform buffer binding of ClusterBlock, firstUnit: first of three texture units
+	ClusteredLights(GLuint blockBinding, GLuint firstUnit = MaterialBindings::kClusterUnit)
+		: m_Binding(blockBinding), m_FirstUnit(firstUnit)
+	{
+		// no lights until the first Update: one cluster, empty
+		Block block;
+		block.depthRow = glm::vec4(0.0f);
+		block.scale = glm::vec4(0.0f);
+		block.grid = glm::ivec4(1, 1, 1, 0);
+		glGenBuffers(1, &m_UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &block, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+		glGenBuffers(3, m_Buffers);
+		glGenTextures(3, m_Textures);
+		for (int i = 0; i < 3; i++)
+		{
+			// never empty, so a texelFetch before the first Update stays defined
+			glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[i]);
+			glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+			glBindTexture(GL_TEXTURE_BUFFER, m_Textures[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_Buffers[i]);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		MaterialBindings::Invalidate();
+		upload(std::vector<glm::uvec2>(kClusters, glm::uvec2(0)), std::vector<GLuint>());
+	}
+
+	~ClusteredLights()
+	{
+		glDeleteBuffers(1, &m_UBO);
+		glDeleteBuffers(3, m_Buffers);
+		glDeleteTextures(3, m_Textures);
+	}
+
+	ClusteredLights(const ClusteredLights&) = delete;
+	ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+	// Binds the program's ClusterBlock and points its samplers at the units; leaves the program in use
+	void Attach(GLuint program) const
+	{
+		GLuint block = glGetUniformBlockIndex(program, "ClusterBlock");
+		if (block == GL_INVALID_INDEX)
+		{
+			std::cout << "ERROR::CLUSTERED_LIGHTS:: program " << program << " has no ClusterBlock" << std::endl;
+			return;
+		}
+		glUniformBlockBinding(program, block, m_Binding);
+		glUseProgram(program);
+		const char* samplers[3] = { "clusterLights", "clusterRanges", "clusterIndices" };
+		for (int i = 0; i < 3; i++)
+			glUniform1i(glGetUniformLocation(program, samplers[i]), (GLint)(m_FirstUnit + i));
+	}
+
+	void Clear() { m_Lights.clear(); }
+
+	// color is premultiplied by the intensity; the light has no effect beyond radius
+	void Add(const glm::vec3& position, float radius, const glm::vec3& color)
+	{
+		Light light;
+		light.positionRadius = glm::vec4(position, radius);
+		light.color = glm::vec4(color, 0.0f);
+		m_Lights.push_back(light);
+	}
+
+	size_t Count() const { return m_Lights.size(); }
+
+	// Bins the lights added since Clear() for this camera and uploads them.
+	// projection has to be a glm::perspective one; width / height are the framebuffer's size in pixels.
+	void Update(const glm::mat4& view, const glm::mat4& projection, int width, int height)
+	{
+		// near / far back out of the projection matrix
+		float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+		float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+		float logRange = std::log(farPlane / nearPlane);
+
+		Block block;
+		block.depthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+		block.scale = glm::vec4((float)kTilesX / width, (float)kTilesY / height,
+			kSlices / logRange, -kSlices * std::log(nearPlane) / logRange);
+		block.grid = glm::ivec4(kTilesX, kTilesY, kSlices, (int)m_Lights.size());
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		// cluster range of every light, then counts -> offsets -> index list (two passes, no per-cluster vectors)
+		std::vector<glm::ivec3> first(m_Lights.size()), last(m_Lights.size());
+		std::vector<glm::uvec2> ranges(kClusters, glm::uvec2(0));
+		std::vector<bool> visible(m_Lights.size(), false);
+		for (size_t i = 0; i < m_Lights.size(); i++)
+		{
+			visible[i] = clusterRange(m_Lights[i], view, projection, nearPlane, farPlane, logRange, first[i], last[i]);
+			if (visible[i])
+				forEachCluster(first[i], last[i], [&](int cluster) { ranges[cluster].y++; });
+		}
+		GLuint offset = 0;
+		for (glm::uvec2& range : ranges)
+		{
+			range.x = offset;
+			offset += range.y;
+			range.y = 0;
+		}
+		std::vector<GLuint> indices(offset);
+		for (size_t i = 0; i < m_Lights.size(); i++)
+			if (visible[i])
+				forEachCluster(first[i], last[i], [&](int cluster) {
+					indices[ranges[cluster].x + ranges[cluster].y++] = (GLuint)i;
+				});
+
+		upload(ranges, indices);
+	}
+
+	// puts the buffer textures and the block on their bindings, before drawing with any attached program
+	void Bind() const
+	{
+		for (int i = 0; i < 3; i++)
+			MaterialBindings::Bind(m_FirstUnit + i, m_Textures[i], GL_TEXTURE_BUFFER);
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_UBO);
+	}
+
+private:
+	// texels of clusterLights
+	struct Light {
+		glm::vec4 positionRadius;
+		glm::vec4 color;
+	};
+
+	// std140 layout of ClusterBlock
+	struct Block {
+		glm::vec4 depthRow; // dot with (worldPos, 1) = view depth
+		glm::vec4 scale;    // xy: tiles per pixel, z / w: slice = log(depth) * z + w
+		glm::ivec4 grid;    // tiles x, tiles y, slices, light count
+	};
+
+	GLuint m_UBO = 0;
+	GLuint m_Buffers[3] = { 0, 0, 0 };  // lights, cluster ranges, light indices
+	GLuint m_Textures[3] = { 0, 0, 0 };
+	GLuint m_Binding;
+	GLuint m_FirstUnit;
+	std::vector<Light> m_Lights;
+
+	// first / last cluster (x, y, slice) the light's sphere can touch, false when it is off screen
+	static bool clusterRange(const Light& light, const glm::mat4& view, const glm::mat4& projection,
+		float nearPlane, float farPlane, float logRange, glm::ivec3& first, glm::ivec3& last)
+	{
+		glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+		float radius = light.positionRadius.w;
+		float nearDepth = -center.z - radius, farDepth = -center.z + radius;
+		if (farDepth < nearPlane || nearDepth > farPlane)
+			return false;
+		nearDepth = std::max(nearDepth, nearPlane);
+		farDepth = std::min(farDepth, farPlane);
+
+		// corners of the sphere's view space box (in front of the near plane), projected
+		glm::vec2 minNdc(1.0f), maxNdc(-1.0f);
+		const float depths[2] = { nearDepth, farDepth };
+		for (float depth : depths)
+			for (int corner = 0; corner < 4; corner++)
+			{
+				glm::vec4 p(center.x + ((corner & 1) ? radius : -radius), center.y + ((corner & 2) ? radius : -radius), -depth, 1.0f);
+				glm::vec4 clip = projection * p;
+				glm::vec2 ndc = glm::vec2(clip) / clip.w;
+				minNdc = glm::min(minNdc, ndc);
+				maxNdc = glm::max(maxNdc, ndc);
+			}
+		if (maxNdc.x < -1.0f || minNdc.x > 1.0f || maxNdc.y < -1.0f || minNdc.y > 1.0f)
+			return false;
+
+		first = glm::ivec3(tile(minNdc.x, kTilesX), tile(minNdc.y, kTilesY), slice(nearDepth, nearPlane, logRange));
+		last = glm::ivec3(tile(maxNdc.x, kTilesX), tile(maxNdc.y, kTilesY), slice(farDepth, nearPlane, logRange));
+		return true;
+	}
+
+	static int tile(float ndc, int tiles)
+	{
+		return std::min(std::max((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0), tiles - 1);
+	}
+
+	static int slice(float depth, float nearPlane, float logRange)
+	{
+		return std::min(std::max((int)std::floor(std::log(depth / nearPlane) / logRange * kSlices), 0), kSlices - 1);
+	}
+
+	template <typename F>
+	static void forEachCluster(const glm::ivec3& first, const glm::ivec3& last, F f)
+	{
+		for (int z = first.z; z <= last.z; z++)
+			for (int y = first.y; y <= last.y; y++)
+				for (int x = first.x; x <= last.x; x++)
+					f((z * kTilesY + y) * kTilesX + x);
+	}
+
+	void upload(const std::vector<glm::uvec2>& ranges, const std::vector<GLuint>& indices)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[0]);
+		if (!m_Lights.empty())
+			glBufferData(GL_TEXTURE_BUFFER, m_Lights.size() * sizeof(Light), m_Lights.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[1]);
+		glBufferData(GL_TEXTURE_BUFFER, ranges.size() * sizeof(glm::uvec2), ranges.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_Buffers[2]);
+		if (!indices.empty())
+			glBufferData(GL_TEXTURE_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+};
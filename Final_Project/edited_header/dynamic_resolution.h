@@ -0,0 +1,122 @@
+// Render scale that follows the GPU frame time, so heavy scenes lose resolution instead of frame rate.
+// BeginFrame() / EndFrame() wrap the frame's GL work in a GL_TIME_ELAPSED query. Queries are kept
+// in a small ring and only read once the GPU reports them available, so measuring never stalls;
+// frames are just measured a few frames late. The smoothed time drives Scale(): above the target
+// the pixel count is cut in proportion (the frame cost is mostly per pixel), well below it the
+// scale creeps back up. Scales move in 5% steps and wait until frames at the new size have been
+// measured, so the scene targets don't change size every frame.
+// The program renders its scene at ScaledSize() and upscales to the window (upscale.fs sharpens).
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+class DynamicResolution
+{
+public:
+	// targetMilliseconds: GPU time per frame to stay under; the scale stays within [minScale, maxScale]
+	DynamicResolution(float targetMilliseconds = 16.0f, float minScale = 0.5f, float maxScale = 1.0f)
+		: m_Target(targetMilliseconds), m_MinScale(minScale), m_MaxScale(maxScale), m_Scale(maxScale)
+	{
+		glGenQueries(kQueries, m_Queries);
+	}
+
+	~DynamicResolution()
+	{
+		glDeleteQueries(kQueries, m_Queries);
+	}
+
+	DynamicResolution(const DynamicResolution&) = delete;
+	DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+	// before the frame's first GL command: takes in finished measurements and starts this frame's
+	void BeginFrame()
+	{
+		while (m_Pending > 0)
+		{
+			GLuint query = m_Queries[(m_Next + kQueries - m_Pending) % kQueries];
+			GLint available = 0;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			m_Pending--;
+			// frames drawn before the last scale change say nothing about the new size
+			if (m_Stale > 0)
+			{
+				m_Stale--;
+				continue;
+			}
+			// over a second is no frame time (Mesa's llvmpipe reports a timestamp for the very first query)
+			if (nanoseconds < 1000000000ull)
+				measured((float)(nanoseconds / 1.0e6));
+		}
+		// every query still in flight (GPU far behind): this frame goes unmeasured
+		m_Measuring = m_Pending < kQueries;
+		if (m_Measuring)
+			glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Next]);
+	}
+
+	// after the frame's last GL command, before swapping buffers
+	void EndFrame()
+	{
+		if (!m_Measuring)
+			return;
+		glEndQuery(GL_TIME_ELAPSED);
+		m_Next = (m_Next + 1) % kQueries;
+		m_Pending++;
+		m_Measuring = false;
+	}
+
+	float Scale() const { return m_Scale; }
+
+	// smoothed GPU time of the last measured frames, 0 before the first one
+	float GpuMilliseconds() const { return m_Average; }
+
+	// size to render the scene at for a width x height window
+	glm::ivec2 ScaledSize(int width, int height) const
+	{
+		return glm::ivec2(std::max((int)std::lround(width * m_Scale), 1), std::max((int)std::lround(height * m_Scale), 1));
+	}
+
+private:
+	static const int kQueries = 4;
+	static const int kSettleFrames = 4; // frames measured at a new size before it is judged
+
+	GLuint m_Queries[kQueries];
+	int m_Next = 0;     // query the next frame uses
+	int m_Pending = 0;  // ended, not read back yet
+	int m_Stale = 0;    // of those, still drawn at the previous scale (dropped when read)
+	bool m_Measuring = false;
+	float m_Target;
+	float m_MinScale;
+	float m_MaxScale;
+	float m_Scale;
+	float m_Average = 0.0f;
+	int m_FramesAtScale = 0;
+
+	void measured(float milliseconds)
+	{
+		m_Average = m_Average == 0.0f ? milliseconds : m_Average + (milliseconds - m_Average) * 0.15f;
+		if (++m_FramesAtScale < kSettleFrames)
+			return;
+
+		// time ~ pixels ~ scale^2: aim a little under the target when shrinking, grow at most 10% at a time
+		float scale = m_Scale;
+		if (m_Average > m_Target)
+			scale = m_Scale * std::sqrt(m_Target * 0.9f / m_Average);
+		else if (m_Average < m_Target * 0.7f)
+			scale = m_Scale * std::min(std::sqrt(m_Target * 0.8f / m_Average), 1.1f);
+		scale = std::min(std::max(std::floor(scale * 20.0f + 0.5f) / 20.0f, m_MinScale), m_MaxScale);
+		if (scale == m_Scale)
+			return;
+		m_Scale = scale;
+		m_FramesAtScale = 0;
+		m_Average = 0.0f; // the old size's times say little about the new one
+		m_Stale = m_Pending; // and the queries still in flight measured the old size too
+	}
+};
@@ -0,0 +1,53 @@
+// Per-frame camera data in one std140 uniform buffer, shared by every program.
+// Shaders declare the FrameData block (same layout as FrameUniforms::Data) instead of their own
+// view / projection / viewPos uniforms; Shader binds the block to BlockBinding("FrameData") at link
+// time, so one Update() per frame replaces the per-program uniform sets.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+
+class FrameUniforms
+{
+public:
+	FrameUniforms()
+	{
+		glGenBuffers(1, &m_UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	~FrameUniforms() { glDeleteBuffers(1, &m_UBO); }
+
+	FrameUniforms(const FrameUniforms&) = delete;
+	FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+	// uploads the camera and binds the buffer, so every program drawing afterwards sees it
+	void Update(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& viewPos, float time)
+	{
+		Data data;
+		data.projection = projection;
+		data.view = view;
+		data.viewPos = glm::vec4(viewPos, 1.0f);
+		data.time = time;
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, Shader::BlockBinding("FrameData"), m_UBO);
+	}
+
+private:
+	// std140 layout of FrameData in the shaders
+	struct Data {
+		glm::mat4 projection;
+		glm::mat4 view;
+		glm::vec4 viewPos;   // w unused
+		float time;          // seconds since start
+		float padding[3];    // the block is rounded up to a vec4
+	};
+
+	GLuint m_UBO = 0;
+};
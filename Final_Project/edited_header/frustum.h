@@ -0,0 +1,133 @@
+// Bounding volumes and view-frustum tests used to skip draws that can't be seen.
+// Bounds are computed once when a Mesh/Model loads, then moved into world space per draw.
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <cmath>
+
+struct AABB
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool IsValid() const { return min.x <= max.x; }
+	glm::vec3 Center() const { return (min + max) * 0.5f; }
+	glm::vec3 Extents() const { return (max - min) * 0.5f; }
+
+	void Expand(const glm::vec3& p)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	void Expand(const AABB& other)
+	{
+		if (!other.IsValid())
+			return;
+		Expand(other.min);
+		Expand(other.max);
+	}
+
+	// Box around this box after an affine transform (Arvo's method, no 8-corner loop)
+	AABB Transformed(const glm::mat4& m) const
+	{
+		if (!IsValid())
+			return *this;
+
+		glm::vec3 center = glm::vec3(m * glm::vec4(Center(), 1.0f));
+		glm::vec3 extents = Extents();
+		glm::vec3 newExtents(0.0f);
+		for (int col = 0; col < 3; col++)
+			for (int row = 0; row < 3; row++)
+				newExtents[row] += std::fabs(m[col][row]) * extents[col];
+
+		AABB out;
+		out.min = center - newExtents;
+		out.max = center + newExtents;
+		return out;
+	}
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+
+	BoundingSphere() {}
+	BoundingSphere(const glm::vec3& c, float r) : center(c), radius(r) {}
+
+	// Radius grows by the largest axis scale so non-uniform scales stay conservative
+	BoundingSphere Transformed(const glm::mat4& m) const
+	{
+		float sx = glm::length(glm::vec3(m[0]));
+		float sy = glm::length(glm::vec3(m[1]));
+		float sz = glm::length(glm::vec3(m[2]));
+		float maxScale = glm::max(sx, glm::max(sy, sz));
+		return BoundingSphere(glm::vec3(m * glm::vec4(center, 1.0f)), radius * maxScale);
+	}
+};
+
+class Frustum
+{
+public:
+	// plane = (normal, d), inside when dot(normal, p) + d >= 0
+	glm::vec4 planes[6];
+
+	Frustum() {}
+	Frustum(const glm::mat4& viewProjection) { Update(viewProjection); }
+
+	// Gribb/Hartmann plane extraction from projection * view
+	void Update(const glm::mat4& m)
+	{
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		planes[0] = row3 + row0; // left
+		planes[1] = row3 - row0; // right
+		planes[2] = row3 + row1; // bottom
+		planes[3] = row3 - row1; // top
+		planes[4] = row3 + row2; // near
+		planes[5] = row3 - row2; // far
+
+		for (int i = 0; i < 6; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+
+	bool Intersects(const BoundingSphere& s) const
+	{
+		for (int i = 0; i < 6; i++)
+			if (glm::dot(glm::vec3(planes[i]), s.center) + planes[i].w < -s.radius)
+				return false;
+		return true;
+	}
+
+	bool Intersects(const AABB& box) const
+	{
+		if (!box.IsValid())
+			return true; // nothing known about it, don't cull
+
+		glm::vec3 center = box.Center();
+		glm::vec3 extents = box.Extents();
+		for (int i = 0; i < 6; i++) {
+			glm::vec3 n = glm::vec3(planes[i]);
+			float r = glm::dot(extents, glm::abs(n));
+			if (glm::dot(n, center) + planes[i].w < -r)
+				return false;
+		}
+		return true;
+	}
+};
+
+// Approximate on-screen radius of a sphere in pixels, for dropping objects too small to see
+inline float ProjectedRadius(const BoundingSphere& s, const glm::vec3& cameraPos,
+	const glm::mat4& projection, float viewportHeight)
+{
+	float dist = glm::length(s.center - cameraPos);
+	if (dist <= s.radius)
+		return FLT_MAX;
+	return s.radius * projection[1][1] * 0.5f * viewportHeight / dist;
+}
@@ -0,0 +1,278 @@
+// Shared vertex/index storage for static meshes.
+// Instead of a VAO + VBO + EBO per Mesh there is one large VBO and VAO per vertex format and a single
+// EBO for everything. Meshes get ranges out of them through a free-list allocator and draw with
+// glDrawElementsBaseVertex, so consecutive meshes of the same format never switch buffers.
+// Buffers double in size (glCopyBufferSubData) when they run out.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// one vertex attribute of an interleaved layout
+struct VertexAttribute {
+	GLuint location;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	bool integer;
+	unsigned int source; // where Mesh copies it from (offset in Vertex or PackedVertex)
+	unsigned int bytes;
+	unsigned int offset; // offset inside one vertex of the layout
+};
+
+// first-fit free list over [0, capacity), neighbouring free blocks are merged back together
+class RangeAllocator
+{
+public:
+	static const size_t npos = SIZE_MAX;
+
+	explicit RangeAllocator(size_t capacity = 0) { Grow(capacity); }
+
+	size_t Capacity() const { return m_Capacity; }
+
+	// offset of a block of size bytes starting at a multiple of alignment, or npos if nothing fits
+	size_t Allocate(size_t size, size_t alignment)
+	{
+		for (auto it = m_Free.begin(); it != m_Free.end(); ++it)
+		{
+			size_t start = it->first, length = it->second;
+			size_t aligned = (start + alignment - 1) / alignment * alignment;
+			size_t padding = aligned - start;
+			if (padding + size > length)
+				continue;
+
+			m_Free.erase(it);
+			if (padding > 0)
+				m_Free[start] = padding;
+			if (length - padding - size > 0)
+				m_Free[aligned + size] = length - padding - size;
+			return aligned;
+		}
+		return npos;
+	}
+
+	void Free(size_t offset, size_t size)
+	{
+		if (size == 0)
+			return;
+		auto next = m_Free.lower_bound(offset);
+		if (next != m_Free.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = m_Free.erase(next);
+		}
+		if (next != m_Free.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += size;
+				return;
+			}
+		}
+		m_Free[offset] = size;
+	}
+
+	void Grow(size_t newCapacity)
+	{
+		if (newCapacity > m_Capacity)
+		{
+			size_t added = newCapacity - m_Capacity;
+			size_t start = m_Capacity;
+			m_Capacity = newCapacity;
+			Free(start, added);
+		}
+	}
+
+private:
+	std::map<size_t, size_t> m_Free; // offset -> size
+	size_t m_Capacity = 0;
+};
+
+// where a mesh's data ended up
+struct GeometryRange {
+	int format = -1;          // -1 = not allocated
+	GLint baseVertex = 0;     // first vertex, passed to glDrawElementsBaseVertex
+	size_t vertexOffset = 0;  // bytes into the format's VBO
+	size_t vertexBytes = 0;
+	size_t indexOffset = 0;   // bytes into the shared EBO
+	size_t indexBytes = 0;
+};
+
+class GeometryPool
+{
+public:
+	static GeometryPool& Get()
+	{
+		static GeometryPool pool;
+		return pool;
+	}
+
+	// Copies one mesh's vertices (in the given layout) and indices into the pool
+	GeometryRange Allocate(const std::vector<VertexAttribute>& layout, GLsizei stride,
+		const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes)
+	{
+		GeometryRange range;
+		range.format = findFormat(layout, stride);
+		Format& format = m_Formats[range.format];
+
+		range.vertexBytes = vertexBytes;
+		range.vertexOffset = format.vertices.Allocate(vertexBytes, stride);
+		if (range.vertexOffset == RangeAllocator::npos)
+		{
+			growVertices(format, vertexBytes);
+			range.vertexOffset = format.vertices.Allocate(vertexBytes, stride);
+		}
+		range.baseVertex = (GLint)(range.vertexOffset / stride);
+
+		range.indexBytes = indexBytes;
+		if (indexBytes > 0)
+		{
+			range.indexOffset = m_Indices.Allocate(indexBytes, 4);
+			if (range.indexOffset == RangeAllocator::npos)
+			{
+				growIndices(indexBytes);
+				range.indexOffset = m_Indices.Allocate(indexBytes, 4);
+			}
+		}
+
+		// upload through the copy target so whatever VAO is bound keeps its element buffer
+		glBindBuffer(GL_COPY_WRITE_BUFFER, format.vbo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, range.vertexOffset, vertexBytes, vertexData);
+		if (indexBytes > 0)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, range.indexOffset, indexBytes, indexData);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return range;
+	}
+
+	void Free(GeometryRange& range)
+	{
+		if (range.format < 0)
+			return;
+		m_Formats[range.format].vertices.Free(range.vertexOffset, range.vertexBytes);
+		m_Indices.Free(range.indexOffset, range.indexBytes);
+		range.format = -1;
+	}
+
+	GLuint VertexArray(int format) const { return m_Formats[format].vao; }
+
+private:
+	struct Format {
+		std::vector<VertexAttribute> layout;
+		GLsizei stride;
+		GLuint vao = 0, vbo = 0;
+		RangeAllocator vertices;
+	};
+
+	const size_t kInitialBytes = 4 * 1024 * 1024;
+
+	std::vector<Format> m_Formats;
+	GLuint m_EBO = 0;
+	RangeAllocator m_Indices;
+
+	GeometryPool()
+	{
+		glGenBuffers(1, &m_EBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+		glBufferData(GL_COPY_WRITE_BUFFER, kInitialBytes, NULL, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_Indices.Grow(kInitialBytes);
+	}
+
+	static bool sameLayout(const Format& format, const std::vector<VertexAttribute>& layout, GLsizei stride)
+	{
+		if (format.stride != stride || format.layout.size() != layout.size())
+			return false;
+		for (size_t i = 0; i < layout.size(); i++)
+		{
+			const VertexAttribute& a = format.layout[i];
+			const VertexAttribute& b = layout[i];
+			if (a.location != b.location || a.size != b.size || a.type != b.type ||
+				a.normalized != b.normalized || a.integer != b.integer || a.offset != b.offset)
+				return false;
+		}
+		return true;
+	}
+
+	int findFormat(const std::vector<VertexAttribute>& layout, GLsizei stride)
+	{
+		for (size_t i = 0; i < m_Formats.size(); i++)
+			if (sameLayout(m_Formats[i], layout, stride))
+				return (int)i;
+
+		Format format;
+		format.layout = layout;
+		format.stride = stride;
+		size_t bytes = kInitialBytes / stride * stride;
+		glGenBuffers(1, &format.vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, format.vbo);
+		glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		format.vertices.Grow(bytes);
+		glGenVertexArrays(1, &format.vao);
+		setupVertexArray(format);
+
+		m_Formats.push_back(format);
+		return (int)m_Formats.size() - 1;
+	}
+
+	// (re)points a format's VAO at its current VBO and the shared EBO
+	void setupVertexArray(const Format& format)
+	{
+		glBindVertexArray(format.vao);
+		glBindBuffer(GL_ARRAY_BUFFER, format.vbo);
+		for (const VertexAttribute& a : format.layout)
+		{
+			if (a.integer)
+				glVertexAttribIPointer(a.location, a.size, a.type, format.stride, (void*)(size_t)a.offset);
+			else
+				glVertexAttribPointer(a.location, a.size, a.type, a.normalized, format.stride, (void*)(size_t)a.offset);
+			glEnableVertexAttribArray(a.location);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// new buffer at least twice as big, old contents copied over on the GPU
+	static GLuint growBuffer(GLuint buffer, size_t oldBytes, size_t newBytes)
+	{
+		GLuint bigger;
+		glGenBuffers(1, &bigger);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+		glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		return bigger;
+	}
+
+	void growVertices(Format& format, size_t needed)
+	{
+		size_t oldBytes = format.vertices.Capacity();
+		size_t newBytes = std::max(oldBytes * 2, oldBytes + needed + format.stride) / format.stride * format.stride;
+		format.vbo = growBuffer(format.vbo, oldBytes, newBytes);
+		format.vertices.Grow(newBytes);
+		setupVertexArray(format);
+	}
+
+	void growIndices(size_t needed)
+	{
+		size_t oldBytes = m_Indices.Capacity();
+		size_t newBytes = std::max(oldBytes * 2, oldBytes + needed + 4);
+		m_EBO = growBuffer(m_EBO, oldBytes, newBytes);
+		m_Indices.Grow(newBytes);
+		for (const Format& format : m_Formats)
+			setupVertexArray(format);
+	}
+};
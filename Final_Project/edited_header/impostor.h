@@ -0,0 +1,163 @@
+// Billboard stand-in for far away static scenery.
+// At startup the Model is rendered from a ring of views around its vertical axis into one atlas
+// texture. Past a distance it is drawn as a single camera-facing quad showing the two nearest
+// views blended. Between nearDistance and nearDistance + blendRange both are drawn with
+// complementary screen-door dithering (Fade() into the mesh shader's "dissolve" and the quad's "fade").
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <learnopengl/shader.h>
+#include <learnopengl/model_animation.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/frame_uniforms.h>
+
+class Impostor
+{
+public:
+	GLuint atlas = 0;       // views side by side, RGBA with alpha = coverage
+	int views = 0;
+	int tileSize = 0;
+	glm::vec3 center;       // quad center relative to the instance position
+	glm::vec2 halfSize;     // quad half width / half height
+	float nearDistance = 35.0f; // closer than this only the mesh is drawn
+	float blendRange = 5.0f;    // distance over which mesh and quad cross-fade
+
+	// orientation: rotation/scale the instances are drawn with (their model matrix without the
+	// translation); it gets baked into the views. captureShader is a static mesh shader.
+	Impostor(Model& model, Shader& captureShader, const glm::mat4& orientation, int views = 8, int tileSize = 256)
+		: views(views), tileSize(tileSize)
+	{
+		AABB bounds = model.aabb.Transformed(orientation);
+		center = bounds.Center();
+		glm::vec3 extents = bounds.Extents();
+		halfSize = glm::vec2(glm::length(glm::vec2(extents.x, extents.z)), extents.y);
+		float radius = glm::length(extents);
+
+		MaterialBindings::Invalidate();
+		glGenTextures(1, &atlas);
+		glBindTexture(GL_TEXTURE_2D, atlas);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, views * tileSize, tileSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		GLuint depth, fbo;
+		glGenRenderbuffers(1, &depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, views * tileSize, tileSize);
+
+		GLint previousFbo, previousViewport[4];
+		GLfloat previousClear[4];
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+		glGetIntegerv(GL_VIEWPORT, previousViewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClear);
+
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::IMPOSTOR:: capture framebuffer is not complete" << std::endl;
+
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// orthographic views around +Y, view i looks from angle 2*pi*i/views
+		glm::mat4 projection = glm::ortho(-halfSize.x, halfSize.x, -halfSize.y, halfSize.y, 0.0f, 2.0f * radius + 2.0f);
+		// own camera buffer; the caller's FrameUniforms::Update rebinds the frame's one afterwards
+		FrameUniforms captureCamera;
+		captureShader.use();
+		captureShader.setMat4("model", orientation);
+		captureShader.setMat3("normalMatrix", glm::mat3(glm::transpose(glm::inverse(orientation))));
+		for (int i = 0; i < views; i++)
+		{
+			float angle = 2.0f * 3.14159265f * i / views;
+			glm::vec3 direction(std::sin(angle), 0.0f, std::cos(angle));
+			glm::vec3 eye = center + direction * (radius + 1.0f);
+			captureCamera.Update(projection, glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)), eye, 0.0f);
+			glViewport(i * tileSize, 0, tileSize, tileSize);
+			model.Draw(captureShader);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+		glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+		glClearColor(previousClear[0], previousClear[1], previousClear[2], previousClear[3]);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(1, &depth);
+
+		MaterialBindings::Invalidate(); // the capture draws bound the model's textures
+		glBindTexture(GL_TEXTURE_2D, atlas);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	~Impostor()
+	{
+		glDeleteTextures(1, &atlas);
+	}
+
+	// 0 = mesh only, 1 = quad only, in between both are drawn
+	float Fade(const glm::vec3& position, const glm::vec3& cameraPos) const
+	{
+		float distance = glm::length(cameraPos - (position + center));
+		return glm::clamp((distance - nearDistance) / blendRange, 0.0f, 1.0f);
+	}
+
+	BoundingSphere Bounds(const glm::vec3& position) const
+	{
+		return BoundingSphere(position + center, glm::length(halfSize));
+	}
+
+	// impostorShader must be in use, FrameUniforms updated for the frame
+	void Draw(Shader& impostorShader, const glm::vec3& position, const glm::vec3& cameraPos, float fade)
+	{
+		// pick the two captured views either side of the camera's angle around the object
+		glm::vec3 toCamera = cameraPos - (position + center);
+		float angle = std::atan2(toCamera.x, toCamera.z);
+		float view = angle / (2.0f * 3.14159265f) * views;
+		view -= std::floor(view / views) * views;
+		int tileA = (int)view % views;
+		int tileB = (tileA + 1) % views;
+
+		impostorShader.setVec3("center", position + center);
+		impostorShader.setVec2("halfSize", halfSize);
+		impostorShader.setFloat("views", (float)views);
+		impostorShader.setFloat("tileA", (float)tileA);
+		impostorShader.setFloat("tileB", (float)tileB);
+		impostorShader.setFloat("tileBlend", view - std::floor(view));
+		impostorShader.setFloat("fade", fade);
+		impostorShader.setInt("atlas", 0);
+
+		MaterialBindings::Invalidate();
+		glBindTexture(GL_TEXTURE_2D, atlas);
+		glBindVertexArray(quadVAO());
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		glBindVertexArray(0);
+	}
+
+private:
+	// one -1..1 quad shared by every impostor
+	static GLuint quadVAO()
+	{
+		static GLuint vao = 0;
+		if (vao == 0)
+		{
+			const float corners[] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+			GLuint vbo;
+			glGenVertexArrays(1, &vao);
+			glGenBuffers(1, &vbo);
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+			glBindVertexArray(0);
+		}
+		return vao;
+	}
+};
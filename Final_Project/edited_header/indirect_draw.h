@@ -0,0 +1,259 @@
+// Multi-draw-indirect submission for repeated static content (GL 4.3+ contexts only).
+// Draws are queued with Add() (after the usual culling / LOD pick) and Submit() sends them as one
+// glMultiDrawElementsIndirect per GeometryPool format and texture set. AddArrays() queues plain
+// non-indexed VAOs the same way, those go out with glMultiDrawArraysIndirect. Per-draw matrices live in a
+// storage buffer; every command's baseInstance is its index there, read back in the vertex shader
+// through the instanced drawIndex attribute (location 7). Shaders need the INDIRECT_DRAW define.
+// The GL 3.3 path (Model::Draw with uniforms) stays the fallback when Supported() is false.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <learnopengl/shader.h>
+#include <learnopengl/model_animation.h>
+
+// not part of a GL 3.3 glad, loaded by hand in Load()
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+
+class IndirectDraw
+{
+public:
+	// location of the per-draw id attribute in INDIRECT_DRAW shaders
+	static const GLuint kDrawIndexLocation = 7;
+
+	// Looks up the 4.3 entry points, call once after gladLoadGLLoader with the same loader
+	static void Load(GLADloadproc load)
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		if (major > 4 || (major == 4 && minor >= 3))
+		{
+			multiDrawElementsIndirect() = (MultiDrawElementsIndirectProc)load("glMultiDrawElementsIndirect");
+			multiDrawArraysIndirect() = (MultiDrawArraysIndirectProc)load("glMultiDrawArraysIndirect");
+		}
+	}
+
+	// true when the context can take this path (context version >= 4.3 and the entry points loaded)
+	static bool Supported() { return multiDrawElementsIndirect() != nullptr && multiDrawArraysIndirect() != nullptr; }
+
+	IndirectDraw()
+	{
+		glGenBuffers(1, &m_DrawBuffer);
+		glGenBuffers(1, &m_CommandBuffer);
+		glGenBuffers(1, &m_DrawIndexBuffer);
+	}
+
+	~IndirectDraw()
+	{
+		glDeleteBuffers(1, &m_DrawBuffer);
+		glDeleteBuffers(1, &m_CommandBuffer);
+		glDeleteBuffers(1, &m_DrawIndexBuffer);
+	}
+
+	// Queues every pooled (static) mesh of the model at the given detail level; skinned meshes are skipped
+	void Add(const Model& model, const glm::mat4& modelMatrix, int lod = 0)
+	{
+		GLuint drawIndex = (GLuint)m_Draws.size();
+		addDraw(modelMatrix);
+
+		for (unsigned int i : model.drawOrder)
+		{
+			const Mesh& mesh = model.meshes[i];
+			if (!mesh.pooled)
+				continue;
+
+			const MeshLod& level = mesh.lods[std::min(std::max(lod, 0), (int)mesh.lods.size() - 1)];
+			size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+			Command command;
+			command.count = level.indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = (GLuint)(level.indexOffset / indexSize);
+			command.baseVertex = mesh.Geometry().baseVertex;
+			command.baseInstance = drawIndex;
+			batchFor(mesh.VAO, mesh.indexType, &mesh.material).commands.push_back(command);
+		}
+	}
+
+	// Queues count vertices from first of a non-indexed VAO, e.g. a cube drawn with glDrawArrays.
+	// material: textures for the draw (batches split on it), nullptr when the shader samples none
+	void AddArrays(GLuint vao, GLint first, GLsizei count, const glm::mat4& modelMatrix, const Material* material = nullptr)
+	{
+		ArraysCommand command;
+		command.count = (GLuint)count;
+		command.instanceCount = 1;
+		command.first = (GLuint)first;
+		command.baseInstance = (GLuint)m_Draws.size();
+		addDraw(modelMatrix);
+		batchFor(vao, GL_NONE, material).arrayCommands.push_back(command);
+	}
+
+	// Draws everything queued since the last Submit with shader (in use, view/projection set), then clears the queue
+	void Submit(Shader& shader)
+	{
+		if (m_Draws.empty())
+			return;
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_DrawBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_Draws.size() * sizeof(DrawData), &m_Draws[0], GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_DrawBuffer);
+		updateDrawIndices();
+
+		// every batch's commands back to back in one buffer, the glDrawArrays-style ones after the indexed ones
+		std::vector<Command> commands;
+		std::vector<ArraysCommand> arrayCommands;
+		for (const Batch& batch : m_Batches)
+		{
+			commands.insert(commands.end(), batch.commands.begin(), batch.commands.end());
+			arrayCommands.insert(arrayCommands.end(), batch.arrayCommands.begin(), batch.arrayCommands.end());
+		}
+		size_t arraysStart = commands.size() * sizeof(Command);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, arraysStart + arrayCommands.size() * sizeof(ArraysCommand), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, arraysStart, commands.data());
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, arraysStart, arrayCommands.size() * sizeof(ArraysCommand), arrayCommands.data());
+
+		size_t offset = 0, arraysOffset = arraysStart;
+		for (const Batch& batch : m_Batches)
+		{
+			if (batch.commands.empty() && batch.arrayCommands.empty())
+				continue;
+			if (batch.material)
+				batch.material->Bind(shader.ID);
+			glBindVertexArray(batch.vao);
+			enableDrawIndex(batch.vao);
+			if (batch.indexType != GL_NONE)
+			{
+				multiDrawElementsIndirect()(GL_TRIANGLES, batch.indexType, (void*)(offset * sizeof(Command)),
+					(GLsizei)batch.commands.size(), 0);
+				offset += batch.commands.size();
+			}
+			else
+			{
+				multiDrawArraysIndirect()(GL_TRIANGLES, (void*)arraysOffset, (GLsizei)batch.arrayCommands.size(), 0);
+				arraysOffset += batch.arrayCommands.size() * sizeof(ArraysCommand);
+			}
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		m_Draws.clear();
+		m_Batches.clear(); // they point at materials, which may not outlive the frame
+	}
+
+private:
+	typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+	typedef void (APIENTRYP MultiDrawArraysIndirectProc)(GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+	// DrawElementsIndirectCommand as the GL reads it
+	struct Command {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// DrawArraysIndirectCommand
+	struct ArraysCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	// std430 layout of DrawBlock in the shaders
+	struct DrawData {
+		glm::mat4 model;
+		glm::mat4 normalMatrix; // mat3 padded to columns of vec4
+	};
+
+	// draws that can go in one call: same VAO, index type and textures
+	struct Batch {
+		GLuint vao;
+		GLenum indexType; // GL_NONE: non-indexed, arrayCommands instead of commands
+		const Material* material; // of the first draw of the batch
+		std::vector<Command> commands;
+		std::vector<ArraysCommand> arrayCommands;
+	};
+
+	GLuint m_DrawBuffer = 0, m_CommandBuffer = 0, m_DrawIndexBuffer = 0;
+	GLuint m_DrawIndexCount = 0; // ids 0..n-1 currently in m_DrawIndexBuffer
+	std::vector<DrawData> m_Draws;
+	std::vector<Batch> m_Batches;
+	std::vector<GLuint> m_PreparedVAOs;
+
+	static MultiDrawElementsIndirectProc& multiDrawElementsIndirect()
+	{
+		static MultiDrawElementsIndirectProc proc = nullptr;
+		return proc;
+	}
+
+	static MultiDrawArraysIndirectProc& multiDrawArraysIndirect()
+	{
+		static MultiDrawArraysIndirectProc proc = nullptr;
+		return proc;
+	}
+
+	void addDraw(const glm::mat4& modelMatrix)
+	{
+		DrawData draw;
+		draw.model = modelMatrix;
+		draw.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
+		m_Draws.push_back(draw);
+	}
+
+	static bool sameMaterial(const Material* a, const Material* b)
+	{
+		return a == b || (a && b && *a == *b);
+	}
+
+	Batch& batchFor(GLuint vao, GLenum indexType, const Material* material)
+	{
+		for (Batch& batch : m_Batches)
+			if (batch.vao == vao && batch.indexType == indexType && sameMaterial(batch.material, material))
+				return batch;
+		Batch batch;
+		batch.vao = vao;
+		batch.indexType = indexType;
+		batch.material = material;
+		m_Batches.push_back(batch);
+		return m_Batches.back();
+	}
+
+	// instance i of a command reads element baseInstance + i; here instanceCount is 1, so it's the draw's id
+	void updateDrawIndices()
+	{
+		if (m_Draws.size() <= m_DrawIndexCount)
+			return;
+		m_DrawIndexCount = std::max((GLuint)m_Draws.size(), m_DrawIndexCount * 2);
+		std::vector<GLuint> ids(m_DrawIndexCount);
+		for (GLuint i = 0; i < m_DrawIndexCount; i++)
+			ids[i] = i;
+		glBindBuffer(GL_ARRAY_BUFFER, m_DrawIndexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// the pool VAOs don't have the id attribute until they are first drawn here; 3.3 draws don't read it
+	void enableDrawIndex(GLuint vao)
+	{
+		if (std::find(m_PreparedVAOs.begin(), m_PreparedVAOs.end(), vao) != m_PreparedVAOs.end())
+			return;
+		glBindBuffer(GL_ARRAY_BUFFER, m_DrawIndexBuffer);
+		glVertexAttribIPointer(kDrawIndexLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+		glVertexAttribDivisor(kDrawIndexLocation, 1);
+		glEnableVertexAttribArray(kDrawIndexLocation);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_PreparedVAOs.push_back(vao);
+	}
+};
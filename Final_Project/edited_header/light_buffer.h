@@ -0,0 +1,178 @@
+// Light list for the multiple_lights shader in one std140 uniform buffer (the LightBlock block).
+// Changing a light only marks the list dirty; Upload() then writes the header and the used point
+// lights with a single glBufferSubData. The point light count is part of the block, so lights can be
+// added or removed at runtime without recompiling the shader, up to kMaxPointLights (which has to
+// match MAX_POINT_LIGHTS in the shader).
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+struct DirLight {
+	glm::vec3 direction;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+};
+
+struct PointLight {
+	glm::vec3 position;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float constant = 1.0f;
+	float linear = 0.09f;
+	float quadratic = 0.032f;
+};
+
+class LightBuffer
+{
+public:
+	static const size_t kMaxPointLights = 64;
+
+	// binding: uniform buffer binding point the block is attached to
+	explicit LightBuffer(GLuint binding = 0)
+		: m_Binding(binding)
+	{
+		glGenBuffers(1, &m_UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	~LightBuffer() { glDeleteBuffers(1, &m_UBO); }
+
+	LightBuffer(const LightBuffer&) = delete;
+	LightBuffer& operator=(const LightBuffer&) = delete;
+
+	// points the program's LightBlock at this buffer's binding, once per program
+	void Attach(GLuint program) const
+	{
+		GLuint block = glGetUniformBlockIndex(program, "LightBlock");
+		if (block == GL_INVALID_INDEX)
+		{
+			std::cout << "ERROR::LIGHT_BUFFER:: program " << program << " has no LightBlock" << std::endl;
+			return;
+		}
+		GLint size = 0;
+		glGetActiveUniformBlockiv(program, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+		if ((size_t)size != sizeof(Block))
+			std::cout << "ERROR::LIGHT_BUFFER:: LightBlock is " << size << " bytes in the shader, expected " << sizeof(Block)
+				<< " (MAX_POINT_LIGHTS " << kMaxPointLights << ")" << std::endl;
+		glUniformBlockBinding(program, block, m_Binding);
+	}
+
+	void SetDirLight(const DirLight& light)
+	{
+		m_DirLight = light;
+		m_Dirty = true;
+	}
+
+	// index of the new light, -1 when the block is full
+	int AddPointLight(const PointLight& light)
+	{
+		if (m_PointLights.size() >= kMaxPointLights)
+			return -1;
+		m_PointLights.push_back(light);
+		m_Dirty = true;
+		return (int)m_PointLights.size() - 1;
+	}
+
+	void SetPointLight(size_t index, const PointLight& light)
+	{
+		m_PointLights[index] = light;
+		m_Dirty = true;
+	}
+
+	// later lights move down by one
+	void RemovePointLight(size_t index)
+	{
+		m_PointLights.erase(m_PointLights.begin() + index);
+		m_Dirty = true;
+	}
+
+	void ClearPointLights()
+	{
+		m_PointLights.clear();
+		m_Dirty = true;
+	}
+
+	const DirLight& GetDirLight() const { return m_DirLight; }
+	const PointLight& GetPointLight(size_t index) const { return m_PointLights[index]; }
+	size_t PointLightCount() const { return m_PointLights.size(); }
+
+	// writes the lights if anything changed and binds the buffer; call before drawing with the lights
+	void Upload()
+	{
+		if (m_Dirty)
+		{
+			pack();
+			size_t bytes = offsetof(Block, pointLights) + m_PointLights.size() * sizeof(PackedPointLight);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, &m_Block);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			m_Dirty = false;
+		}
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_UBO);
+	}
+
+private:
+	// std140 layout of the shader structs: every vec3 starts on 16 bytes, a following float fills the gap
+	struct PackedDirLight {
+		glm::vec4 direction;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+	};
+
+	struct PackedPointLight {
+		glm::vec3 position;
+		float constant;
+		glm::vec3 ambient;
+		float linear;
+		glm::vec3 diffuse;
+		float quadratic;
+		glm::vec4 specular;
+	};
+
+	struct Block {
+		PackedDirLight dirLight;
+		GLint pointLightCount;
+		GLint padding[3]; // arrays of structs start on 16 bytes
+		PackedPointLight pointLights[kMaxPointLights];
+	};
+	static_assert(sizeof(PackedPointLight) == 64, "PointLight must match its std140 layout");
+	static_assert(offsetof(Block, pointLights) == 80, "LightBlock header must match its std140 layout");
+
+	GLuint m_UBO = 0;
+	GLuint m_Binding;
+	bool m_Dirty = true;
+	DirLight m_DirLight = DirLight();
+	std::vector<PointLight> m_PointLights;
+	Block m_Block;
+
+	void pack()
+	{
+		m_Block.dirLight.direction = glm::vec4(m_DirLight.direction, 0.0f);
+		m_Block.dirLight.ambient = glm::vec4(m_DirLight.ambient, 0.0f);
+		m_Block.dirLight.diffuse = glm::vec4(m_DirLight.diffuse, 0.0f);
+		m_Block.dirLight.specular = glm::vec4(m_DirLight.specular, 0.0f);
+		m_Block.pointLightCount = (GLint)m_PointLights.size();
+		for (size_t i = 0; i < m_PointLights.size(); i++)
+		{
+			const PointLight& light = m_PointLights[i];
+			PackedPointLight& packed = m_Block.pointLights[i];
+			packed.position = light.position;
+			packed.constant = light.constant;
+			packed.ambient = light.ambient;
+			packed.linear = light.linear;
+			packed.diffuse = light.diffuse;
+			packed.quadratic = light.quadratic;
+			packed.specular = glm::vec4(light.specular, 0.0f);
+		}
+	}
+};
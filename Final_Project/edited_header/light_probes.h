@@ -0,0 +1,222 @@
+// Baked L2 spherical-harmonic light probes for ambient lighting of moving objects (the character).
+// At startup every probe of a grid along the course projects the static environment (sky / ground
+// gradient, the background wall) and the static point lights into 9 SH coefficients, already
+// convolved with the cosine lobe and divided by pi, so tex * Evaluate(normal) is the lit color.
+// Per frame the grid is interpolated at the object on the CPU, dynamic lights close to it can be
+// folded in with AddPointLight, and the 9 coefficients go to the shader (LIGHT_PROBE in anim_model.fs).
+// Visibility is not traced: probes see every light and the whole environment.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <learnopengl/material.h>
+
+struct SH9
+{
+	glm::vec3 c[9];
+
+	SH9()
+	{
+		for (int i = 0; i < 9; i++)
+			c[i] = glm::vec3(0.0f);
+	}
+
+	// real SH basis up to l = 2 at unit direction d
+	static void Basis(const glm::vec3& d, float y[9])
+	{
+		y[0] = 0.282095f;
+		y[1] = 0.488603f * d.y;
+		y[2] = 0.488603f * d.z;
+		y[3] = 0.488603f * d.x;
+		y[4] = 1.092548f * d.x * d.y;
+		y[5] = 1.092548f * d.y * d.z;
+		y[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		y[7] = 1.092548f * d.x * d.z;
+		y[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+
+	// cosine lobe convolution per band (pi, 2pi/3, pi/4), over pi
+	static float Band(int i)
+	{
+		return i == 0 ? 1.0f : (i < 4 ? 2.0f / 3.0f : 0.25f);
+	}
+
+	// diffuse light of a far source from direction (unit), intensity = light on a surface facing it
+	void AddDirectional(const glm::vec3& direction, const glm::vec3& intensity)
+	{
+		float y[9];
+		Basis(direction, y);
+		for (int i = 0; i < 9; i++)
+			c[i] += intensity * (Band(i) * y[i] * 3.14159265f);
+	}
+
+	// point light with the falloff of ClusteredLighting() in the shaders, seen from position
+	void AddPointLight(const glm::vec3& position, const glm::vec3& lightPosition, float radius, const glm::vec3& color)
+	{
+		glm::vec3 toLight = lightPosition - position;
+		float distance = glm::length(toLight);
+		if (distance >= radius || distance < 1e-4f)
+			return;
+		float ratio = distance / radius;
+		float window = std::min(std::max(1.0f - ratio * ratio * ratio * ratio, 0.0f), 1.0f);
+		AddDirectional(toLight / distance, color * (window * window / (distance * distance + 1.0f)));
+	}
+
+	glm::vec3 Evaluate(const glm::vec3& normal) const
+	{
+		float y[9];
+		Basis(normal, y);
+		glm::vec3 result(0.0f);
+		for (int i = 0; i < 9; i++)
+			result += c[i] * y[i];
+		return glm::max(result, glm::vec3(0.0f));
+	}
+
+	SH9& operator+=(const SH9& other)
+	{
+		for (int i = 0; i < 9; i++)
+			c[i] += other.c[i];
+		return *this;
+	}
+
+	SH9 operator*(float s) const
+	{
+		SH9 result;
+		for (int i = 0; i < 9; i++)
+			result.c[i] = c[i] * s;
+		return result;
+	}
+};
+
+// a static point light seen by the probes (same falloff as the clustered lights)
+struct ProbeLight {
+	glm::vec3 position;
+	float radius;
+	glm::vec3 color;
+};
+
+// what the probes are baked from
+struct ProbeEnvironment {
+	glm::vec3 skyColor = glm::vec3(1.0f);    // radiance straight up, blended to groundColor over the horizon
+	glm::vec3 groundColor = glm::vec3(0.5f); // radiance straight down
+	glm::vec3 wallColor = glm::vec3(0.0f);   // a wall filling the directions within wallAngle of wallDirection
+	glm::vec3 wallDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	float wallAngle = 0.0f;                  // radians, 0 = no wall
+	std::vector<ProbeLight> lights;
+	float period = 0.0f;                     // > 0: the lights repeat every period along x
+};
+
+class LightProbeGrid
+{
+public:
+	// counts.x probes from origin.x in steps of spacing.x (and the same for y / z); with wrapX the grid
+	// is one period of a course that repeats along x, so it has to span the environment's period
+	LightProbeGrid(const glm::vec3& origin, const glm::vec3& spacing, const glm::ivec3& counts, bool wrapX)
+		: m_Origin(origin), m_Spacing(spacing), m_Counts(counts), m_WrapX(wrapX),
+		m_Probes((size_t)counts.x * counts.y * counts.z)
+	{
+	}
+
+	size_t ProbeCount() const { return m_Probes.size(); }
+
+	void Bake(const ProbeEnvironment& environment, int samples = 256)
+	{
+		// the environment part is the same at every probe, projected once with a Fibonacci sphere
+		SH9 ambient;
+		float y[9];
+		float weight = 4.0f * 3.14159265f / samples;
+		float cosWall = std::cos(environment.wallAngle);
+		for (int s = 0; s < samples; s++)
+		{
+			float z = 1.0f - 2.0f * (s + 0.5f) / samples;
+			float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+			float phi = s * 2.39996323f;
+			glm::vec3 direction(r * std::cos(phi), z, r * std::sin(phi)); // y up
+			glm::vec3 radiance = glm::mix(environment.groundColor, environment.skyColor, direction.y * 0.5f + 0.5f);
+			if (environment.wallAngle > 0.0f && glm::dot(direction, environment.wallDirection) >= cosWall)
+				radiance = environment.wallColor;
+			SH9::Basis(direction, y);
+			for (int i = 0; i < 9; i++)
+				ambient.c[i] += radiance * (y[i] * weight * SH9::Band(i));
+		}
+
+		for (int z = 0; z < m_Counts.z; z++)
+			for (int yIndex = 0; yIndex < m_Counts.y; yIndex++)
+				for (int x = 0; x < m_Counts.x; x++)
+				{
+					glm::vec3 position = m_Origin + m_Spacing * glm::vec3((float)x, (float)yIndex, (float)z);
+					SH9 probe = ambient;
+					for (const ProbeLight& light : environment.lights)
+					{
+						// with a period the neighbouring copies of the light can reach the probe too
+						int copies = environment.period > 0.0f ? (int)std::ceil(light.radius / environment.period) : 0;
+						for (int k = -copies; k <= copies; k++)
+							probe.AddPointLight(position, light.position + glm::vec3(k * environment.period, 0.0f, 0.0f), light.radius, light.color);
+					}
+					m_Probes[index(x, yIndex, z)] = probe;
+				}
+	}
+
+	// trilinear blend of the 8 probes around position (x wraps with wrapX, the rest is clamped)
+	SH9 Sample(const glm::vec3& position) const
+	{
+		glm::vec3 cell = (position - m_Origin) / m_Spacing;
+		int lower[3], upper[3];
+		float t[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int count = m_Counts[axis];
+			float f = cell[axis];
+			if (axis == 0 && m_WrapX)
+				f -= std::floor(f / count) * count;
+			else
+				f = std::min(std::max(f, 0.0f), (float)(count - 1));
+			lower[axis] = std::min((int)std::floor(f), count - 1);
+			t[axis] = f - lower[axis];
+			upper[axis] = (axis == 0 && m_WrapX) ? (lower[axis] + 1) % count : std::min(lower[axis] + 1, count - 1);
+		}
+
+		SH9 result;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			int x = (corner & 1) ? upper[0] : lower[0];
+			int yIndex = (corner & 2) ? upper[1] : lower[1];
+			int z = (corner & 4) ? upper[2] : lower[2];
+			float w = ((corner & 1) ? t[0] : 1.0f - t[0]) * ((corner & 2) ? t[1] : 1.0f - t[1]) * ((corner & 4) ? t[2] : 1.0f - t[2]);
+			if (w > 0.0f)
+				result += m_Probes[index(x, yIndex, z)] * w;
+		}
+		return result;
+	}
+
+	// average color of a mipmapped 2D texture (its 1x1 level), e.g. to use a picture as the wall
+	static glm::vec3 AverageColor(GLuint texture)
+	{
+		MaterialBindings::Invalidate();
+		glBindTexture(GL_TEXTURE_2D, texture);
+		GLint width = 0, height = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		int level = (int)std::floor(std::log2((float)std::max(std::max(width, height), 1)));
+		float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_FLOAT, texel);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return glm::vec3(texel[0], texel[1], texel[2]);
+	}
+
+private:
+	glm::vec3 m_Origin;
+	glm::vec3 m_Spacing;
+	glm::ivec3 m_Counts;
+	bool m_WrapX;
+	std::vector<SH9> m_Probes;
+
+	size_t index(int x, int y, int z) const
+	{
+		return ((size_t)z * m_Counts.y + y) * m_Counts.x + x;
+	}
+};
@@ -0,0 +1,151 @@
+// Texture bindings for Mesh::Draw without per-draw string building or uniform lookups.
+// Every sampler name ("texture_diffuse1", "texture_normal1", ...) gets a fixed texture unit the first
+// time a Material uses it. A program has its sampler uniforms pointed at those units once (the value
+// is program state and never changes afterwards), so drawing only binds textures, and a texture that
+// is already on its unit isn't bound again.
+// Code that binds textures itself must call MaterialBindings::Invalidate() first.
+// Units from kMaterialUnits up are reserved for the fixed bindings of ShadowMaps and ClusteredLights.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class MaterialBindings
+{
+public:
+	static const GLuint kMaterialUnits = 10; // units UnitFor hands out to sampler names
+	static const GLuint kShadowUnit = 10;    // ShadowMaps: static map, dynamic map on the next one
+	static const GLuint kClusterUnit = 12;   // ClusteredLights: its three buffer textures from here
+
+	// fixed unit of a sampler uniform name, assigned in order of first use
+	static GLuint UnitFor(const std::string& sampler)
+	{
+		State& state = get();
+		for (size_t i = 0; i < state.samplers.size(); i++)
+			if (state.samplers[i] == sampler)
+				return (GLuint)i;
+		if (state.samplers.size() == kMaterialUnits)
+		{
+			// the next units belong to the shadow maps and light clusters, don't bind over them
+			std::cout << "ERROR::MATERIAL:: no texture unit left for " << sampler << ", sharing unit " << kMaterialUnits - 1 << std::endl;
+			return kMaterialUnits - 1;
+		}
+		state.samplers.push_back(sampler);
+		return (GLuint)state.samplers.size() - 1;
+	}
+
+	// Points the program's samplers at their units; only names it hasn't been given yet are looked up.
+	// The program must be in use.
+	static void Prepare(GLuint program)
+	{
+		State& state = get();
+		ProgramSamplers* entry = nullptr;
+		for (ProgramSamplers& p : state.programs)
+			if (p.program == program)
+				entry = &p;
+		if (entry == nullptr)
+		{
+			state.programs.push_back(ProgramSamplers{ program, 0 });
+			entry = &state.programs.back();
+		}
+		for (; entry->prepared < state.samplers.size(); entry->prepared++)
+		{
+			GLint location = glGetUniformLocation(program, state.samplers[entry->prepared].c_str());
+			if (location >= 0)
+				glUniform1i(location, (GLint)entry->prepared);
+		}
+	}
+
+	// binds texture on unit, skipped when it is already there
+	static void Bind(GLuint unit, GLuint texture, GLenum target = GL_TEXTURE_2D)
+	{
+		State& state = get();
+		if (unit < state.bound.size() && state.bound[unit].texture == texture && state.bound[unit].target == target)
+			return;
+		if (unit >= state.bound.size())
+			state.bound.resize(unit + 1, BoundTexture{ GL_NONE, 0 });
+		if (state.active != (GLint)unit)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			state.active = (GLint)unit;
+		}
+		glBindTexture(target, texture);
+		state.bound[unit] = BoundTexture{ target, texture };
+	}
+
+	// Forgets what is bound and makes unit 0 active again, for code that binds textures on its own
+	static void Invalidate()
+	{
+		State& state = get();
+		state.bound.clear();
+		glActiveTexture(GL_TEXTURE0);
+		state.active = 0;
+	}
+
+private:
+	struct ProgramSamplers {
+		GLuint program;
+		size_t prepared; // samplers[0..prepared) already set on it
+	};
+
+	struct BoundTexture {
+		GLenum target;
+		GLuint texture;
+	};
+
+	struct State {
+		std::vector<std::string> samplers; // index = unit
+		std::vector<ProgramSamplers> programs;
+		std::vector<BoundTexture> bound;   // last Bind on each unit, as far as Bind knows
+		GLint active = -1;                 // active unit, -1 = unknown
+	};
+
+	static State& get()
+	{
+		static State state;
+		return state;
+	}
+};
+
+// A mesh's textures resolved to units, built once when the mesh is created
+class Material
+{
+public:
+	void Add(const std::string& sampler, GLuint texture, GLenum target = GL_TEXTURE_2D)
+	{
+		m_Bindings.push_back(Binding{ MaterialBindings::UnitFor(sampler), texture, target });
+	}
+
+	// program: the shader in use
+	void Bind(GLuint program) const
+	{
+		MaterialBindings::Prepare(program);
+		for (const Binding& binding : m_Bindings)
+			MaterialBindings::Bind(binding.unit, binding.texture, binding.target);
+	}
+
+	// groups draws with the same textures when sorting (RenderQueue): the first texture, 0 without any
+	GLuint SortKey() const { return m_Bindings.empty() ? 0 : m_Bindings[0].texture; }
+
+	bool operator==(const Material& other) const
+	{
+		if (m_Bindings.size() != other.m_Bindings.size())
+			return false;
+		for (size_t i = 0; i < m_Bindings.size(); i++)
+			if (m_Bindings[i].unit != other.m_Bindings[i].unit || m_Bindings[i].texture != other.m_Bindings[i].texture)
+				return false;
+		return true;
+	}
+
+private:
+	struct Binding {
+		GLuint unit;
+		GLuint texture;
+		GLenum target;
+	};
+	std::vector<Binding> m_Bindings;
+};
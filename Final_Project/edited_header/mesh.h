@@ -0,0 +1,594 @@
+// Edited from LearnOpenGL mesh.h
+// - every Mesh keeps an AABB and bounding sphere of its vertices, computed once at load, for culling
+// - maxInfluences: most bones any vertex uses, so the cheapest skinning shader variant can be picked
+// - skinned meshes carry a compact bone palette (boneRemap), vertex bone ids index into it; UploadBonePalette sends it
+// - Draw can use another VAO over the same indices (pre-skinned positions), VBO/EBO readable
+// - optional 32 byte PackedVertex GPU layout (on by default), SetVertexAttributes describes either layout
+// - only the attributes the drawing shader reads are uploaded (VertexAttribsOf), plus a position-only
+//   stream for depth/shadow passes on static meshes (DrawDepth)
+// - triangles reordered for the post-transform cache and overdraw, vertices for fetch locality,
+//   16 bit indices below 65536 vertices; cacheBefore/cacheAfter keep the ACMR/ATVR numbers
+// - optional LOD chain for static meshes: quadric-simplified index lists over the same vertices,
+//   all in one EBO, picked with the lod argument of Draw/DrawDepth
+// - Release() frees the GL objects (Mesh copies share them, so only call it on the last user)
+// - static meshes live in the shared GeometryPool buffers (one VAO per vertex format) and draw with
+//   glDrawElementsBaseVertex; skinned meshes keep their own VAO/VBO/EBO for the skin prepass
+// - BindTextures split out of Draw and Geometry() exposes the pool range, for IndirectDraw
+// - textures resolved once into a Material (fixed unit per sampler name), Draw no longer builds
+//   sampler names, looks up uniforms or rebinds textures that are already bound
+// - optional per-vertex texture array layer (ATTRIB_LAYER, location 8) and Texture::target, for
+//   meshes merged by Model::BuildTextureArray
+// - DrawBound() issues only the draw call, for the RenderQueue's state-sorted execution
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h> // holds all OpenGL type declarations
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplify.h>
+#include <learnopengl/geometry_pool.h>
+#include <learnopengl/material.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+
+#define MAX_BONE_INFLUENCE 4
+// bones one skinned draw may reference; meshes using more are split at import
+#define MAX_MESH_BONES 64
+
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+	//bone indexes which will influence this vertex
+	int m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone
+	float m_Weights[MAX_BONE_INFLUENCE];
+	// texture array layer, see Model::BuildTextureArray
+	unsigned int Layer = 0;
+};
+
+// What actually goes to the GPU for packed meshes: 32 bytes instead of Vertex's 88.
+// GL unpacks every field in the vertex fetch, so the shaders keep their vec3/vec2/ivec4/vec4 inputs.
+// The bitangent is not stored: bitangent = cross(normal, tangent.xyz) * tangent.w
+struct PackedVertex {
+    glm::vec3 Position;
+    uint32_t  Normal;         // snorm 10_10_10_2
+    uint32_t  Tangent;        // snorm 10_10_10, w = bitangent sign
+    uint16_t  TexCoords[2];   // half floats
+    int8_t    m_BoneIDs[MAX_BONE_INFLUENCE]; // mesh palette slots (< MAX_MESH_BONES), -1 = none
+    uint8_t   m_Weights[MAX_BONE_INFLUENCE]; // unorm8, summing to 255 on skinned vertices
+    uint8_t   Layer[4];       // texture array layer in [0], rest keeps the attribute 4 byte aligned
+};
+// Layer is only uploaded by texture array meshes, everything else stays 32 bytes
+static_assert(offsetof(PackedVertex, Layer) == 32, "PackedVertex attributes should stay 32 bytes");
+
+// One bit per vertex attribute location, used to upload only what a shader actually reads
+enum VertexAttribBits : unsigned int {
+    ATTRIB_POSITION  = 1 << 0,
+    ATTRIB_NORMAL    = 1 << 1,
+    ATTRIB_TEXCOORDS = 1 << 2,
+    ATTRIB_TANGENT   = 1 << 3,
+    ATTRIB_BITANGENT = 1 << 4,
+    ATTRIB_BONE_IDS  = 1 << 5,
+    ATTRIB_WEIGHTS   = 1 << 6,
+    ATTRIB_ALL       = 0x7F,
+    ATTRIB_LAYER     = 1 << 8  // not in ATTRIB_ALL, only texture array meshes have it
+};
+
+// Attribute locations a linked program really uses (the compiler drops inputs it never reads).
+// OR several together when more than one shader draws the same model.
+inline unsigned int VertexAttribsOf(const Shader& shader)
+{
+    GLint count = 0;
+    glGetProgramiv(shader.ID, GL_ACTIVE_ATTRIBUTES, &count);
+
+    unsigned int attribs = ATTRIB_POSITION;
+    for (GLint i = 0; i < count; i++)
+    {
+        GLchar name[64];
+        GLint size;
+        GLenum type;
+        glGetActiveAttrib(shader.ID, i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetAttribLocation(shader.ID, name);
+        if ((location >= 0 && location < 7) || location == 8)
+            attribs |= 1u << location;
+    }
+    // ids are useless without weights and the other way round
+    if (attribs & (ATTRIB_BONE_IDS | ATTRIB_WEIGHTS))
+        attribs |= ATTRIB_BONE_IDS | ATTRIB_WEIGHTS;
+    return attribs;
+}
+
+// one detail level: a range of the mesh's EBO
+struct MeshLod {
+    unsigned int indexCount;
+    size_t indexOffset; // bytes
+};
+
+struct Texture {
+    unsigned int id;
+    string type;
+    string path;
+    GLenum target = GL_TEXTURE_2D; // GL_TEXTURE_2D_ARRAY for Model::BuildTextureArray
+};
+
+class Mesh {
+public:
+    // mesh Data
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    vector<Texture>      textures;
+    // textures by sampler unit, what Draw actually binds
+    Material             material;
+    unsigned int VAO;
+
+    // bind-pose bounds in mesh space
+    AABB aabb;
+    BoundingSphere sphere;
+    // 0 = static mesh, otherwise the highest number of bones on a single vertex
+    int maxInfluences = 0;
+    // local palette slot -> model bone id (-1 = identity, for vertices no bone moves)
+    vector<int> boneRemap;
+    // GPU buffer holds PackedVertex instead of Vertex (vertices stays full precision on the CPU)
+    bool packed = true;
+    // VertexAttribBits actually uploaded; the others read as the GL default (0,0,0,1)
+    unsigned int attribs = ATTRIB_ALL;
+    // GL_UNSIGNED_SHORT when every index fits, otherwise GL_UNSIGNED_INT
+    GLenum indexType = GL_UNSIGNED_INT;
+    // vertex cache efficiency of the index order as imported and as uploaded
+    VertexCacheStats cacheBefore, cacheAfter;
+    // lods[0] is the full mesh, then one entry per requested level (always the same count, a level
+    // that can't be simplified further repeats the previous one)
+    vector<MeshLod> lods;
+    // vertices/indices are a range of the GeometryPool and VAO is the pool's VAO for this format
+    bool pooled = false;
+
+    // constructor
+    // lodLevels: triangle fractions of the extra detail levels, e.g. { 0.5f, 0.25f, 0.1f }; ignored for skinned meshes
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool packVertices = true,
+        unsigned int vertexAttribs = ATTRIB_ALL, const vector<float>& lodLevels = vector<float>())
+    {
+        this->vertices = vertices;
+        this->indices = indices;
+        this->textures = textures;
+        this->packed = packVertices && canPack();
+        this->attribs = vertexAttribs | ATTRIB_POSITION;
+
+        buildMaterial();
+        optimizeOrder();
+        computeBounds();
+        countInfluences();
+        // nothing moves a static mesh, bone data would only be dead weight in the VBO
+        if (maxInfluences == 0)
+            this->attribs &= ~(ATTRIB_BONE_IDS | ATTRIB_WEIGHTS);
+        buildLods(lodLevels);
+
+        // now that we have all the required data, set the vertex buffers and its attribute pointers.
+        setupMesh();
+    }
+
+    // render the mesh
+    void Draw(Shader &shader) 
+    {
+        Draw(shader, VAO, 0);
+    }
+
+    // same textures and indices, but vertex data from another VAO (e.g. pre-skinned output)
+    void Draw(Shader &shader, unsigned int vao, int lod = 0)
+    {
+        BindTextures(shader);
+
+        // draw mesh
+        glBindVertexArray(vao);
+        if (pooled && vao == VAO)
+        {
+            // the pool VAO stays bound, the next pooled mesh of this format doesn't switch buffers
+            drawElements(lod, geometry.baseVertex);
+        }
+        else
+        {
+            drawElements(lod, 0);
+            glBindVertexArray(0);
+        }
+    }
+
+    // the draw call alone, for callers that bound the textures and vao themselves (RenderQueue)
+    void DrawBound(unsigned int vao, int lod = 0) const
+    {
+        drawElements(lod, (pooled && vao == VAO) ? geometry.baseVertex : 0);
+    }
+
+    // binds the material's textures, the shader's texture_diffuseN/specularN/normalN/heightN samplers
+    // already point at their units (set the first time the shader draws a Material)
+    void BindTextures(Shader &shader) const
+    {
+        material.Bind(shader.ID);
+    }
+
+    // Uploads the model bones this mesh references (boneRemap) to a mat4 array uniform in one call.
+    // finalBones is the animator's full palette; scratch is reused between calls.
+    void UploadBonePalette(GLint location, const vector<glm::mat4>& finalBones, vector<glm::mat4>& scratch) const
+    {
+        if (boneRemap.empty())
+            return;
+        scratch.resize(boneRemap.size());
+        for (size_t slot = 0; slot < boneRemap.size(); slot++)
+        {
+            int bone = boneRemap[slot];
+            scratch[slot] = (bone >= 0 && bone < (int)finalBones.size()) ? finalBones[bone] : glm::mat4(1.0f);
+        }
+        glUniformMatrix4fv(location, (GLsizei)scratch.size(), GL_FALSE, &scratch[0][0][0]);
+    }
+
+    // Points attribute locations first..last of the bound VAO at this mesh's VBO, in whichever layout it uses.
+    // 0 position, 1 normal, 2 uv, 3 tangent, 4 bitangent (unpacked only), 5 bone ids, 6 weights, 8 layer
+    void SetVertexAttributes(unsigned int first, unsigned int last) const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (const VertexAttribute& a : layout)
+        {
+            if (a.location < first || a.location > last)
+                continue;
+            if (a.integer)
+                glVertexAttribIPointer(a.location, a.size, a.type, stride, (void*)(size_t)a.offset);
+            else
+                glVertexAttribPointer(a.location, a.size, a.type, a.normalized, stride, (void*)(size_t)a.offset);
+            glEnableVertexAttribArray(a.location);
+        }
+    }
+
+    // positions only, for passes that don't shade (depth prepass, shadow maps)
+    void DrawDepth(int lod = 0)
+    {
+        if (pooled)
+        {
+            glBindVertexArray(GeometryPool::Get().VertexArray(depthGeometry.format));
+            drawElements(lod, depthGeometry.baseVertex);
+            return;
+        }
+        glBindVertexArray(VAO);
+        drawElements(lod, 0);
+        glBindVertexArray(0);
+    }
+
+    // where a pooled mesh sits in the GeometryPool (format < 0 if it isn't pooled)
+    const GeometryRange& Geometry() const { return geometry; }
+
+    // 0 for pooled meshes, their data is somewhere in the pool's buffers
+    unsigned int GetVBO() const { return VBO; }
+    unsigned int GetEBO() const { return EBO; }
+
+    void Release()
+    {
+        if (pooled)
+        {
+            // VAO belongs to the pool; the ranges go back on its free lists
+            GeometryPool::Get().Free(geometry);
+            GeometryPool::Get().Free(depthGeometry);
+            VAO = 0;
+            pooled = false;
+            return;
+        }
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+private:
+    // render data 
+    unsigned int VBO, EBO;
+    // pool ranges of pooled meshes: the shaded vertices + all index levels, and the tightly packed
+    // positions DrawDepth uses (skinned meshes go through the skin prepass instead)
+    GeometryRange geometry, depthGeometry;
+
+    vector<VertexAttribute> layout;
+    GLsizei stride = 0;
+
+    // interleaved layout of the attributes in attribs, in the packed or full format
+    void buildLayout()
+    {
+        static const VertexAttribute packedFormat[] = {
+            { 0, 3, GL_FLOAT,              GL_FALSE, false, offsetof(PackedVertex, Position),  12, 0 },
+            { 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE,  false, offsetof(PackedVertex, Normal),     4, 0 },
+            { 2, 2, GL_HALF_FLOAT,         GL_FALSE, false, offsetof(PackedVertex, TexCoords),  4, 0 },
+            { 3, 4, GL_INT_2_10_10_10_REV, GL_TRUE,  false, offsetof(PackedVertex, Tangent),    4, 0 },
+            { 5, 4, GL_BYTE,               GL_FALSE, true,  offsetof(PackedVertex, m_BoneIDs),  4, 0 },
+            { 6, 4, GL_UNSIGNED_BYTE,      GL_TRUE,  false, offsetof(PackedVertex, m_Weights),  4, 0 },
+            { 8, 1, GL_UNSIGNED_BYTE,      GL_FALSE, true,  offsetof(PackedVertex, Layer),      4, 0 },
+        };
+        static const VertexAttribute fullFormat[] = {
+            { 0, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Position),  12, 0 },
+            { 1, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Normal),    12, 0 },
+            { 2, 2, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, TexCoords),  8, 0 },
+            { 3, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Tangent),   12, 0 },
+            { 4, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Bitangent), 12, 0 },
+            { 5, 4, GL_INT,   GL_FALSE, true,  offsetof(Vertex, m_BoneIDs), 16, 0 },
+            { 6, 4, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, m_Weights), 16, 0 },
+            { 8, 1, GL_UNSIGNED_INT, GL_FALSE, true, offsetof(Vertex, Layer), 4, 0 },
+        };
+
+        layout.clear();
+        stride = 0;
+        const VertexAttribute* format = packed ? packedFormat : fullFormat;
+        int count = packed ? sizeof(packedFormat) / sizeof(packedFormat[0]) : sizeof(fullFormat) / sizeof(fullFormat[0]);
+        for (int i = 0; i < count; i++)
+        {
+            if (!(attribs & (1u << format[i].location)))
+                continue;
+            VertexAttribute a = format[i];
+            a.offset = stride;
+            stride += a.bytes;
+            layout.push_back(a);
+        }
+    }
+
+    // sampler names as the shaders expect them: the N-th texture of a type is <type>N
+    void buildMaterial()
+    {
+        material = Material();
+        unsigned int diffuseNr  = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr   = 1;
+        unsigned int heightNr   = 1;
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // retrieve texture number (the N in diffuse_textureN)
+            string number;
+            string name = textures[i].type;
+            if(name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++); // transfer unsigned int to string
+            else if(name == "texture_normal")
+                number = std::to_string(normalNr++); // transfer unsigned int to string
+             else if(name == "texture_height")
+                number = std::to_string(heightNr++); // transfer unsigned int to string
+
+            material.Add(name + number, textures[i].id, textures[i].target);
+        }
+    }
+
+    // box first, then a sphere around the box center that still encloses every vertex
+    void computeBounds()
+    {
+        for (const Vertex& v : vertices)
+            aabb.Expand(v.Position);
+
+        sphere.center = aabb.IsValid() ? aabb.Center() : glm::vec3(0.0f);
+        float maxDist2 = 0.0f;
+        for (const Vertex& v : vertices) {
+            glm::vec3 d = v.Position - sphere.center;
+            maxDist2 = std::max(maxDist2, glm::dot(d, d));
+        }
+        sphere.radius = std::sqrt(maxDist2);
+    }
+
+    void countInfluences()
+    {
+        for (const Vertex& v : vertices) {
+            int count = 0;
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+                if (v.m_BoneIDs[i] >= 0 && v.m_Weights[i] > 0.0f)
+                    count++;
+            maxInfluences = std::max(maxInfluences, count);
+        }
+    }
+
+    // simplified levels, concatenated after the full index list until setupMesh uploads them
+    vector<unsigned int> lodIndices;
+
+    // Each level is simplified from the previous one, then cache-ordered on its own.
+    // lods[].indexOffset is in indices here and turned into bytes once the index type is known.
+    void buildLods(const vector<float>& levels)
+    {
+        lods.clear();
+        lods.push_back(MeshLod{ (unsigned int)indices.size(), 0 });
+        if (levels.empty())
+            return;
+
+        vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].Position;
+
+        vector<unsigned int> previous = indices;
+        size_t offset = indices.size();
+        for (float fraction : levels)
+        {
+            size_t target = (size_t)(indices.size() / 3 * fraction) * 3;
+            vector<unsigned int> level = maxInfluences == 0 ? MeshSimplify::Simplify(previous, positions, target) : previous;
+            if (level.size() == previous.size())
+            {
+                // nothing more to take away (or skinned), reuse the last range
+                lods.push_back(lods.back());
+                continue;
+            }
+            MeshOptimizer::OptimizeVertexCache(level, vertices.size());
+            previous.swap(level);
+            lods.push_back(MeshLod{ (unsigned int)previous.size(), offset });
+            lodIndices.insert(lodIndices.end(), previous.begin(), previous.end());
+            offset += previous.size();
+        }
+    }
+
+    void drawElements(int lod, GLint baseVertex) const
+    {
+        const MeshLod& level = lods[std::min(std::max(lod, 0), (int)lods.size() - 1)];
+        glDrawElementsBaseVertex(GL_TRIANGLES, level.indexCount, indexType, (void*)level.indexOffset, baseVertex);
+    }
+
+    // cache order first, then overdraw within 5% of it, then vertices renumbered to follow the indices
+    void optimizeOrder()
+    {
+        cacheBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+        MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+        vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].Position;
+        MeshOptimizer::OptimizeOverdraw(indices, positions, 1.05f);
+        MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+        cacheAfter = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+    }
+
+    // bone ids must fit a signed byte; true for remapped skinned meshes and for static ones (-1)
+    bool canPack() const
+    {
+        for (const Vertex& v : vertices)
+        {
+            if (v.Layer > 255)
+                return false;
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+                if (v.m_BoneIDs[i] > 127)
+                    return false;
+        }
+        return true;
+    }
+
+    static PackedVertex packVertex(const Vertex& v)
+    {
+        PackedVertex p;
+        p.Position = v.Position;
+        p.Normal = glm::packSnorm3x10_1x2(glm::vec4(safeNormalize(v.Normal), 0.0f));
+        glm::vec3 tangent = safeNormalize(v.Tangent);
+        float handedness = glm::dot(glm::cross(v.Normal, v.Tangent), v.Bitangent) < 0.0f ? -1.0f : 1.0f;
+        p.Tangent = glm::packSnorm3x10_1x2(glm::vec4(tangent, handedness));
+        p.TexCoords[0] = glm::packHalf1x16(v.TexCoords.x);
+        p.TexCoords[1] = glm::packHalf1x16(v.TexCoords.y);
+        p.Layer[0] = (uint8_t)v.Layer;
+        p.Layer[1] = p.Layer[2] = p.Layer[3] = 0;
+
+        // round the weights to bytes so they still add up to exactly 255 (largest remainder)
+        float scaled[MAX_BONE_INFLUENCE];
+        int total = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            p.m_BoneIDs[i] = (int8_t)v.m_BoneIDs[i];
+            scaled[i] = glm::clamp(v.m_Weights[i], 0.0f, 1.0f) * 255.0f;
+            p.m_Weights[i] = (uint8_t)scaled[i];
+            total += p.m_Weights[i];
+        }
+        int target = (int)(scaled[0] + scaled[1] + scaled[2] + scaled[3] + 0.5f);
+        while (total < target && total < 255)
+        {
+            int best = 0;
+            for (int i = 1; i < MAX_BONE_INFLUENCE; i++)
+                if (scaled[i] - p.m_Weights[i] > scaled[best] - p.m_Weights[best])
+                    best = i;
+            p.m_Weights[best]++;
+            total++;
+        }
+        return p;
+    }
+
+    static glm::vec3 safeNormalize(const glm::vec3& v)
+    {
+        float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f);
+    }
+
+    // initializes all the buffer objects/arrays
+    void setupMesh()
+    {
+        // Only the attributes in the layout are copied, one vertex after another
+        buildLayout();
+        vector<unsigned char> data(vertices.size() * stride);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            PackedVertex packedVertex;
+            const unsigned char* source = (const unsigned char*)&vertices[i];
+            if (packed)
+            {
+                packedVertex = packVertex(vertices[i]);
+                source = (const unsigned char*)&packedVertex;
+            }
+            for (const VertexAttribute& a : layout)
+                memcpy(&data[i * stride + a.offset], source + a.source, a.bytes);
+        }
+
+        // every detail level goes into the same index range, one after another
+        vector<unsigned int> allIndices(indices);
+        allIndices.insert(allIndices.end(), lodIndices.begin(), lodIndices.end());
+        vector<unsigned char> indexData;
+        size_t indexSize = vertices.size() <= 65536 ? sizeof(uint16_t) : sizeof(unsigned int);
+        if (indexSize == sizeof(uint16_t))
+        {
+            vector<uint16_t> shortIndices(allIndices.begin(), allIndices.end());
+            indexType = GL_UNSIGNED_SHORT;
+            indexData.assign((unsigned char*)shortIndices.data(), (unsigned char*)(shortIndices.data() + shortIndices.size()));
+        }
+        else
+        {
+            indexType = GL_UNSIGNED_INT;
+            indexData.assign((unsigned char*)allIndices.data(), (unsigned char*)(allIndices.data() + allIndices.size()));
+        }
+        vector<unsigned int>().swap(lodIndices); // only needed for the upload
+
+        if (maxInfluences == 0)
+            setupPooled(data, indexData, indexSize);
+        else
+            setupOwnBuffers(data, indexData, indexSize);
+    }
+
+    // static meshes: shaded vertices and a position-only copy into the pool, sharing one index range
+    void setupPooled(const vector<unsigned char>& data, const vector<unsigned char>& indexData, size_t indexSize)
+    {
+        GeometryPool& pool = GeometryPool::Get();
+        geometry = pool.Allocate(layout, stride, data.data(), data.size(), indexData.data(), indexData.size());
+        VAO = pool.VertexArray(geometry.format);
+        VBO = EBO = 0;
+        pooled = true;
+        for (MeshLod& lod : lods)
+            lod.indexOffset = geometry.indexOffset + lod.indexOffset * indexSize;
+
+        vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].Position;
+        vector<VertexAttribute> positionLayout(1, layout[0]);
+        // the depth copy only needs vertices; point it at the same indices instead of duplicating them
+        depthGeometry = pool.Allocate(positionLayout, sizeof(glm::vec3), positions.data(), positions.size() * sizeof(glm::vec3), NULL, 0);
+        depthGeometry.indexOffset = geometry.indexOffset;
+    }
+
+    void setupOwnBuffers(const vector<unsigned char>& data, const vector<unsigned char>& indexData, size_t indexSize)
+    {
+        // create buffers/arrays
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        // load data into vertex buffers
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
+        for (MeshLod& lod : lods)
+            lod.indexOffset *= indexSize;
+
+        // set the vertex attribute pointers
+        SetVertexAttributes(0, 8);
+        glBindVertexArray(0);
+    }
+};
+#endif
@@ -0,0 +1,284 @@
+// Load-time index/vertex reordering for Mesh, so the GPU re-shades as few vertices as possible.
+// - OptimizeVertexCache: Tom Forsyth's "linear-speed vertex cache optimisation" (LRU cache scoring)
+// - OptimizeOverdraw: cuts the cache-ordered list into clusters and draws outward-facing ones first,
+//   as long as the cache efficiency stays within a threshold of the cache-only order
+// - OptimizeVertexFetch: renumbers vertices in first-use order so fetches walk the VBO linearly
+// - AnalyzeVertexCache: ACMR (misses per triangle) and ATVR (misses per vertex) of a FIFO cache
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+struct VertexCacheStats
+{
+	size_t triangles = 0;
+	size_t vertices = 0;
+	size_t misses = 0;
+
+	// average cache miss ratio, 0.5 is the ideal for a regular grid, 3 is no reuse at all
+	float ACMR() const { return triangles ? (float)misses / triangles : 0.0f; }
+	// average transformed vertex ratio, 1 means every vertex is shaded exactly once
+	float ATVR() const { return vertices ? (float)misses / vertices : 0.0f; }
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other)
+	{
+		triangles += other.triangles;
+		vertices += other.vertices;
+		misses += other.misses;
+		return *this;
+	}
+};
+
+namespace MeshOptimizer
+{
+	const int kOptimizeCacheSize = 32; // LRU size the scoring is tuned for
+	const int kAnalyzeCacheSize = 16;  // FIFO size used for the reported numbers
+
+	// Simulates a FIFO post-transform cache over the index list
+	inline VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+		int cacheSize = kAnalyzeCacheSize)
+	{
+		VertexCacheStats stats;
+		stats.triangles = indices.size() / 3;
+		stats.vertices = vertexCount;
+
+		std::vector<size_t> insertedAt(vertexCount, 0); // cache timestamp + 1, 0 = never cached
+		size_t timestamp = 0;
+		for (unsigned int index : indices)
+		{
+			if (insertedAt[index] == 0 || timestamp - (insertedAt[index] - 1) >= (size_t)cacheSize)
+			{
+				insertedAt[index] = ++timestamp;
+				stats.misses++;
+			}
+		}
+		return stats;
+	}
+
+	inline float vertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the three vertices of the last triangle get a fixed score so it isn't reused immediately
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (float)(cachePosition - 3) / (kOptimizeCacheSize - 3), 1.5f);
+		}
+		// boost vertices with few triangles left so they get finished off instead of stranded
+		score += 2.0f * std::pow((float)remainingTriangles, -0.5f);
+		return score;
+	}
+
+	inline void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// triangles using each vertex, as one flat array with per-vertex ranges
+		std::vector<unsigned int> remaining(vertexCount, 0);
+		for (unsigned int index : indices)
+			remaining[index]++;
+		std::vector<unsigned int> offsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] = offsets[v] + remaining[v];
+		std::vector<unsigned int> adjacency(indices.size());
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> score(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+			score[v] = vertexScore(-1, remaining[v]);
+
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (size_t t = 0; t < triangleCount; t++)
+			triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+		std::vector<unsigned int> cache, newCache;
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		long best = (long)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+		size_t scanStart = 0;
+
+		while (output.size() < indices.size())
+		{
+			if (best < 0)
+			{
+				// nothing useful in the cache, take the next unemitted triangle
+				while (emitted[scanStart])
+					scanStart++;
+				best = (long)scanStart;
+			}
+
+			const unsigned int* tri = &indices[best * 3];
+			output.insert(output.end(), tri, tri + 3);
+			emitted[best] = true;
+
+			// this triangle no longer counts toward its vertices' remaining lists
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = tri[k];
+				unsigned int* list = &adjacency[offsets[v]];
+				for (unsigned int i = 0; i < remaining[v]; i++)
+				{
+					if (list[i] == (unsigned int)best)
+					{
+						list[i] = list[remaining[v] - 1];
+						break;
+					}
+				}
+				remaining[v]--;
+			}
+
+			// move the triangle's vertices to the front of the LRU
+			newCache.assign(tri, tri + 3);
+			for (unsigned int v : cache)
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+					newCache.push_back(v);
+
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				unsigned int v = newCache[i];
+				cachePosition[v] = i < (size_t)kOptimizeCacheSize ? (int)i : -1;
+				score[v] = vertexScore(cachePosition[v], remaining[v]);
+			}
+
+			// rescore the triangles touching anything that moved, the best one is drawn next
+			best = -1;
+			float bestScore = -1.0f;
+			for (unsigned int v : newCache)
+			{
+				for (unsigned int i = 0; i < remaining[v]; i++)
+				{
+					unsigned int t = adjacency[offsets[v] + i];
+					float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+					triangleScore[t] = s;
+					if (s > bestScore)
+					{
+						bestScore = s;
+						best = (long)t;
+					}
+				}
+			}
+
+			if (newCache.size() > (size_t)kOptimizeCacheSize)
+				newCache.resize(kOptimizeCacheSize);
+			cache.swap(newCache);
+		}
+
+		indices.swap(output);
+	}
+
+	// threshold: how much worse than the incoming ACMR the result may get (1.05 = 5%)
+	inline void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+		float threshold = 1.05f)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2)
+			return;
+
+		// a new cluster starts wherever the cache order has to restart (all three vertices missed)
+		std::vector<size_t> clusterStart;
+		std::vector<size_t> insertedAt(positions.size(), 0);
+		size_t timestamp = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			int misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[t * 3 + k];
+				if (insertedAt[v] == 0 || timestamp - (insertedAt[v] - 1) >= (size_t)kAnalyzeCacheSize)
+				{
+					insertedAt[v] = ++timestamp;
+					misses++;
+				}
+			}
+			if (t == 0 || misses == 3)
+				clusterStart.push_back(t);
+		}
+		if (clusterStart.size() < 2)
+			return;
+		clusterStart.push_back(triangleCount);
+
+		glm::vec3 meshCenter(0.0f);
+		for (const glm::vec3& p : positions)
+			meshCenter += p;
+		meshCenter /= (float)positions.size();
+
+		// clusters facing away from the mesh center are more likely to occlude the rest, draw them first
+		size_t clusterCount = clusterStart.size() - 1;
+		std::vector<float> outward(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			glm::vec3 centroid(0.0f), normal(0.0f);
+			float area = 0.0f;
+			for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+			{
+				const glm::vec3& a = positions[indices[t * 3]];
+				const glm::vec3& b = positions[indices[t * 3 + 1]];
+				const glm::vec3& d = positions[indices[t * 3 + 2]];
+				glm::vec3 n = glm::cross(b - a, d - a); // length = twice the area
+				float triangleArea = glm::length(n);
+				centroid += (a + b + d) * (triangleArea / 3.0f);
+				normal += n;
+				area += triangleArea;
+			}
+			if (area > 0.0f)
+				centroid /= area;
+			float normalLength = glm::length(normal);
+			outward[c] = normalLength > 0.0f ? glm::dot(centroid - meshCenter, normal / normalLength) : 0.0f;
+		}
+
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+			order[c] = c;
+		std::stable_sort(order.begin(), order.end(), [&outward](size_t a, size_t b) { return outward[a] > outward[b]; });
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(indices.size());
+		for (size_t c : order)
+			sorted.insert(sorted.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+
+		float before = AnalyzeVertexCache(indices, positions.size()).ACMR();
+		float after = AnalyzeVertexCache(sorted, positions.size()).ACMR();
+		if (after <= before * threshold)
+			indices.swap(sorted);
+	}
+
+	// Renumbers vertices in the order the index list first touches them; unused ones go last
+	template <typename VertexT>
+	void OptimizeVertexFetch(std::vector<VertexT>& vertices, std::vector<unsigned int>& indices)
+	{
+		const unsigned int unassigned = ~0u;
+		std::vector<unsigned int> remap(vertices.size(), unassigned);
+		std::vector<VertexT> reordered;
+		reordered.reserve(vertices.size());
+
+		for (unsigned int& index : indices)
+		{
+			if (remap[index] == unassigned)
+			{
+				remap[index] = (unsigned int)reordered.size();
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		for (size_t v = 0; v < vertices.size(); v++)
+			if (remap[v] == unassigned)
+				reordered.push_back(vertices[v]);
+
+		vertices.swap(reordered);
+	}
+}
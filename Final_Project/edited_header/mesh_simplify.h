@@ -0,0 +1,239 @@
+// Quadric error edge-collapse simplification (Garland & Heckbert) for Mesh LOD chains.
+// Vertices only ever collapse onto one of their neighbours, so a simplified level is just a new
+// index list over the same vertex buffer. Border edges and UV/normal seams (several vertices at one
+// position) are locked so outlines and texture seams don't tear open.
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace MeshSimplify
+{
+	// symmetric 4x4 matrix of a sum of planes, only the upper triangle is stored
+	struct Quadric
+	{
+		float a2 = 0, ab = 0, ac = 0, ad = 0;
+		float b2 = 0, bc = 0, bd = 0;
+		float c2 = 0, cd = 0;
+		float d2 = 0;
+
+		void AddPlane(const glm::vec3& n, float d, float weight)
+		{
+			a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+			b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+			c2 += weight * n.z * n.z; cd += weight * n.z * d;
+			d2 += weight * d * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+		}
+
+		// sum of squared distances from p to the planes
+		float Error(const glm::vec3& p) const
+		{
+			float e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+				+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+				+ c2 * p.z * p.z + 2 * cd * p.z
+				+ d2;
+			return std::fabs(e);
+		}
+	};
+
+	struct Collapse
+	{
+		unsigned int from, to;
+		float error;
+	};
+
+	inline unsigned int resolve(std::vector<unsigned int>& remap, unsigned int v)
+	{
+		while (remap[v] != v)
+			v = remap[v] = remap[remap[v]];
+		return v;
+	}
+
+	// Collapses edges, cheapest first, until at most targetIndexCount indices remain or every
+	// remaining collapse would move the surface by more than maxError (fraction of the mesh size).
+	inline std::vector<unsigned int> Simplify(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+		size_t targetIndexCount, float maxError = 0.05f)
+	{
+		std::vector<unsigned int> result = indices;
+		size_t vertexCount = positions.size();
+		if (result.size() <= targetIndexCount || vertexCount == 0)
+			return result;
+
+		glm::vec3 minP = positions[0], maxP = positions[0];
+		for (const glm::vec3& p : positions)
+		{
+			minP = glm::min(minP, p);
+			maxP = glm::max(maxP, p);
+		}
+		float extent = glm::length(maxP - minP);
+		float errorLimit = (maxError * extent) * (maxError * extent);
+
+		// vertices sharing a position are seams; every copy is locked
+		std::vector<bool> locked(vertexCount, false);
+		{
+			std::map<std::vector<float>, unsigned int> firstAt;
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				std::vector<float> key = { positions[v].x, positions[v].y, positions[v].z };
+				auto found = firstAt.find(key);
+				if (found == firstAt.end())
+					firstAt[key] = v;
+				else
+					locked[v] = locked[found->second] = true;
+			}
+		}
+
+		// edges used by only one triangle are borders
+		{
+			std::map<std::pair<unsigned int, unsigned int>, int> edgeUse;
+			for (size_t t = 0; t + 2 < result.size(); t += 3)
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int a = result[t + k], b = result[t + (k + 1) % 3];
+					edgeUse[std::make_pair(std::min(a, b), std::max(a, b))]++;
+				}
+			for (const auto& edge : edgeUse)
+				if (edge.second == 1)
+					locked[edge.first.first] = locked[edge.first.second] = true;
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t t = 0; t + 2 < result.size(); t += 3)
+		{
+			const glm::vec3& p0 = positions[result[t]];
+			const glm::vec3& p1 = positions[result[t + 1]];
+			const glm::vec3& p2 = positions[result[t + 2]];
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(n);
+			if (area <= 0.0f)
+				continue;
+			n /= area;
+			for (int k = 0; k < 3; k++)
+				quadrics[result[t + k]].AddPlane(n, -glm::dot(n, p0), area);
+		}
+
+		std::vector<unsigned int> remap(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; v++)
+			remap[v] = v;
+
+		// each pass collapses a set of edges that don't touch each other, then rebuilds
+		for (int pass = 0; pass < 64 && result.size() > targetIndexCount; pass++)
+		{
+			std::vector<unsigned int> offsets(vertexCount + 1, 0);
+			for (unsigned int index : result)
+				offsets[index + 1]++;
+			for (size_t v = 0; v < vertexCount; v++)
+				offsets[v + 1] += offsets[v];
+			std::vector<unsigned int> vertexTriangles(result.size());
+			std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+				vertexTriangles[fill[result[i]]++] = (unsigned int)(i / 3);
+
+			std::vector<Collapse> candidates;
+			for (size_t t = 0; t + 2 < result.size(); t += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int a = result[t + k], b = result[t + (k + 1) % 3];
+					if (a > b || (locked[a] && locked[b]))
+						continue; // each edge once (from its lower index), and locked pairs never move
+
+					Quadric q = quadrics[a];
+					q.Add(quadrics[b]);
+					Collapse c;
+					float toB = locked[a] ? FLT_MAX : q.Error(positions[b]);
+					float toA = locked[b] ? FLT_MAX : q.Error(positions[a]);
+					if (toB <= toA) { c.from = a; c.to = b; c.error = toB; }
+					else            { c.from = b; c.to = a; c.error = toA; }
+					if (c.error <= errorLimit)
+						candidates.push_back(c);
+				}
+			}
+			if (candidates.empty())
+				break;
+			std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+			std::vector<bool> touched(vertexCount, false);
+			size_t triangles = result.size() / 3;
+			size_t targetTriangles = targetIndexCount / 3;
+			int collapsed = 0;
+
+			for (const Collapse& c : candidates)
+			{
+				if (triangles <= targetTriangles)
+					break;
+				if (touched[c.from] || touched[c.to])
+					continue;
+
+				// reject collapses that would fold a neighbouring triangle over
+				bool flips = false;
+				int removed = 0;
+				for (unsigned int i = offsets[c.from]; i < offsets[c.from + 1] && !flips; i++)
+				{
+					const unsigned int* tri = &result[vertexTriangles[i] * 3];
+					if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+					{
+						removed++;
+						continue;
+					}
+					glm::vec3 p[3], moved[3];
+					for (int k = 0; k < 3; k++)
+					{
+						p[k] = positions[tri[k]];
+						moved[k] = tri[k] == c.from ? positions[c.to] : p[k];
+					}
+					glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+					if (glm::dot(before, after) <= 0.0f)
+						flips = true;
+				}
+				if (flips)
+					continue;
+
+				remap[c.from] = c.to;
+				quadrics[c.to].Add(quadrics[c.from]);
+				triangles -= removed;
+				collapsed++;
+
+				// everything around the edge is stale for the rest of this pass
+				for (unsigned int end : { c.from, c.to })
+					for (unsigned int i = offsets[end]; i < offsets[end + 1]; i++)
+						for (int k = 0; k < 3; k++)
+							touched[result[vertexTriangles[i] * 3 + k]] = true;
+			}
+			if (collapsed == 0)
+				break;
+
+			// apply the collapses and drop triangles that became degenerate
+			std::vector<unsigned int> next;
+			next.reserve(result.size());
+			for (size_t t = 0; t + 2 < result.size(); t += 3)
+			{
+				unsigned int a = resolve(remap, result[t]);
+				unsigned int b = resolve(remap, result[t + 1]);
+				unsigned int c = resolve(remap, result[t + 2]);
+				if (a == b || b == c || a == c)
+					continue;
+				next.push_back(a);
+				next.push_back(b);
+				next.push_back(c);
+			}
+			result.swap(next);
+		}
+
+		return result;
+	}
+}
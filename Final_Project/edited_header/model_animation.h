@@ -0,0 +1,815 @@
+// Edited from LearnOpenGL model_animation.h
+// - Model keeps the union of its meshes' bounds and can skip meshes outside the view frustum
+// - per-bone boxes of the influenced vertices, so an animated pose gets a tight bound from the bone palette
+// - GetMaxInfluences() to route the model to the cheapest skinning shader variant
+// - import keeps the 4 heaviest influences, sorted and normalized, and rewrites bone ids to a
+//   per-mesh palette of at most MAX_MESH_BONES (splitting meshes that need more); drawOrder
+//   lists meshes by influence count so skinned draws switch shader as little as possible
+// - optional vertexAttribs mask so meshes only upload what their shaders read
+// - import welds identical vertices (JoinIdenticalVertices), otherwise every triangle has its own three
+//   vertices and neither the cache reordering nor the LOD simplification can share anything
+// - prints the vertex cache gain (ACMR/ATVR over all meshes) of the load-time reordering
+// - optional LOD chain (lodLevels) on static meshes, SelectLod picks one from the projected size with hysteresis;
+//   the triangle count of every level is printed at load
+// - BatchStaticMeshes() merges static meshes with identical textures so they draw in one call
+// - TextureFromFile resets MaterialBindings before binding on its own
+// - BuildTextureArray() packs the diffuse textures into one texture array and merges the meshes
+//   (skinned ones too, while their bone palettes fit together) with a per-vertex layer
+// - DrawDepth() draws every mesh's position-only stream, for the shadow map passes
+// - Enqueue() hands the meshes to a RenderQueue instead of drawing them in place
+
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <glad/glad.h> 
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/texture_array.h>
+#include <learnopengl/render_queue.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <learnopengl/assimp_glm_helpers.h>
+#include <learnopengl/animdata.h>
+
+using namespace std;
+
+class Model 
+{
+public:
+    // model data 
+    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Mesh>    meshes;
+    string directory;
+    bool gammaCorrection;
+    unsigned int vertexAttribs;	// VertexAttribBits uploaded for every mesh
+    vector<float> lodLevels;	// triangle fraction of each extra detail level
+    // on-screen radius (pixels) below which the model stops being drawn at full detail;
+    // level i takes over at lodFullDetailRadius * sqrt(lodLevels[i - 1]), so triangles per pixel stay about even
+    float lodFullDetailRadius = 150.0f;
+    float lodHysteresis = 0.15f;	// +-15% band around each switch radius so LODs don't flicker
+
+	// bind-pose bounds in model space, union of all meshes
+	AABB aabb;
+	BoundingSphere sphere;
+	// mesh indices sorted by maxInfluences
+	vector<unsigned int> drawOrder;
+	// layers made by BuildTextureArray (id 0 until then)
+	TextureArray textureArray;
+
+    // constructor, expects a filepath to a 3D model.
+    // vertexAttribs: VertexAttribsOf() the shader(s) that will draw this model, everything else is left out of the VBOs
+    // lodLevels: e.g. { 0.5f, 0.25f, 0.1f } to also build 50/25/10% triangle versions of every static mesh
+    Model(string const &path, bool gamma = false, unsigned int vertexAttribs = ATTRIB_ALL, const vector<float>& lodLevels = vector<float>())
+        : gammaCorrection(gamma), vertexAttribs(vertexAttribs), lodLevels(lodLevels)
+    {
+        loadModel(path);
+        computeBounds();
+        sortByInfluences();
+        reportVertexCache(path);
+        reportLods(path);
+    }
+
+    // draws the model, and thus all its meshes
+    void Draw(Shader &shader, int lod = 0)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, meshes[i].VAO, lod);
+    }
+
+    // positions only, for depth / shadow passes of static models (skinned ones go through SkinPrepass)
+    void DrawDepth(int lod = 0)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].DrawDepth(lod);
+        glBindVertexArray(0);
+    }
+
+    int LodCount() const { return 1 + (int)lodLevels.size(); }
+
+    // Merges static meshes that bind exactly the same textures into one VBO/EBO each. The loader
+    // already puts every mesh in model space, so vertices concatenate as they are; a batch is
+    // closed before it passes 65536 vertices to keep 16 bit indices. All meshes of a Model are
+    // drawn with one shader, so the textures are the whole material. Call once after loading.
+    void BatchStaticMeshes()
+    {
+        vector<Mesh> batched;
+        vector<vector<size_t>> groups; // mesh indices per distinct texture set, in load order
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (meshes[i].maxInfluences > 0)
+            {
+                batched.push_back(meshes[i]); // skinned meshes carry their own bone palette
+                continue;
+            }
+            size_t g = 0;
+            while (g < groups.size() && !sameTextures(meshes[groups[g][0]], meshes[i]))
+                g++;
+            if (g == groups.size())
+                groups.push_back(vector<size_t>());
+            groups[g].push_back(i);
+        }
+
+        size_t before = meshes.size();
+        for (const vector<size_t>& group : groups)
+        {
+            vector<size_t> batch;
+            size_t batchVertices = 0;
+            for (size_t i : group)
+            {
+                if (!batch.empty() && batchVertices + meshes[i].vertices.size() > 65536)
+                {
+                    batched.push_back(batch.size() == 1 ? meshes[batch[0]] : mergeMeshes(batch, meshes[batch[0]].textures, vertexAttribs));
+                    batch.clear();
+                    batchVertices = 0;
+                }
+                batch.push_back(i);
+                batchVertices += meshes[i].vertices.size();
+            }
+            if (!batch.empty())
+                batched.push_back(batch.size() == 1 ? meshes[batch[0]] : mergeMeshes(batch, meshes[batch[0]].textures, vertexAttribs));
+        }
+
+        meshes.swap(batched);
+        sortByInfluences();
+        cout << "MODEL::BATCH " << before << " meshes -> " << meshes.size() << endl;
+    }
+
+    // Copies every mesh's first diffuse texture into one GL_TEXTURE_2D_ARRAY (layers scaled to a common
+    // size, at most maxSize) and merges meshes that used different textures: static ones up to 65536
+    // vertices, skinned ones as long as their bone palettes fit MAX_MESH_BONES together. Each vertex
+    // keeps its texture as a layer (ATTRIB_LAYER); the merged meshes only bind the array, as
+    // "texture_array", so draw them with the TEXTURE_ARRAY variant of anim_model. Call once after loading.
+    void BuildTextureArray(int maxSize = 2048)
+    {
+        vector<GLuint> sources;
+        for (const Mesh& mesh : meshes)
+        {
+            GLuint diffuse = diffuseOf(mesh);
+            if (diffuse != 0 && std::find(sources.begin(), sources.end(), diffuse) == sources.end())
+                sources.push_back(diffuse);
+        }
+        if (sources.empty())
+            return;
+
+        textureArray = TextureArray(sources, maxSize);
+        for (Mesh& mesh : meshes)
+        {
+            unsigned int layer = (unsigned int)std::max(textureArray.LayerOf(diffuseOf(mesh)), 0);
+            for (Vertex& v : mesh.vertices)
+                v.Layer = layer;
+        }
+        Texture arrayTexture;
+        arrayTexture.id = textureArray.id;
+        arrayTexture.type = "texture_array";
+        arrayTexture.target = GL_TEXTURE_2D_ARRAY;
+        vector<Texture> arrayTextures(1, arrayTexture);
+        unsigned int attribs = vertexAttribs | ATTRIB_LAYER;
+
+        vector<Mesh> merged;
+        vector<size_t> staticBatch, skinnedBatch;
+        size_t staticVertices = 0;
+        vector<int> skinnedBones; // union of skinnedBatch's palettes
+        size_t before = meshes.size();
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (meshes[i].maxInfluences == 0)
+            {
+                if (!staticBatch.empty() && staticVertices + meshes[i].vertices.size() > 65536)
+                {
+                    merged.push_back(mergeMeshes(staticBatch, arrayTextures, attribs));
+                    staticBatch.clear();
+                    staticVertices = 0;
+                }
+                staticBatch.push_back(i);
+                staticVertices += meshes[i].vertices.size();
+                continue;
+            }
+
+            size_t added = 0;
+            for (int bone : meshes[i].boneRemap)
+                if (std::find(skinnedBones.begin(), skinnedBones.end(), bone) == skinnedBones.end())
+                    added++;
+            if (!skinnedBatch.empty() && skinnedBones.size() + added > MAX_MESH_BONES)
+            {
+                merged.push_back(mergeMeshes(skinnedBatch, arrayTextures, attribs));
+                skinnedBatch.clear();
+                skinnedBones.clear();
+            }
+            skinnedBatch.push_back(i);
+            for (int bone : meshes[i].boneRemap)
+                if (std::find(skinnedBones.begin(), skinnedBones.end(), bone) == skinnedBones.end())
+                    skinnedBones.push_back(bone);
+        }
+        if (!staticBatch.empty())
+            merged.push_back(mergeMeshes(staticBatch, arrayTextures, attribs));
+        if (!skinnedBatch.empty())
+            merged.push_back(mergeMeshes(skinnedBatch, arrayTextures, attribs));
+
+        meshes.swap(merged);
+        sortByInfluences();
+        cout << "MODEL::TEXTURE_ARRAY " << sources.size() << " layers of " << textureArray.width << "x" << textureArray.height
+            << ", " << before << " meshes -> " << meshes.size() << endl;
+    }
+
+    // Detail level for one instance. currentLod is what that instance used last frame (keep one int
+    // per instance); a level only changes once the size is clearly past the switch radius.
+    int SelectLod(const glm::mat4& model, const glm::vec3& cameraPos, const glm::mat4& projection,
+        float viewportHeight, int currentLod) const
+    {
+        if (lodLevels.empty())
+            return 0;
+
+        float radius = ProjectedRadius(sphere.Transformed(model), cameraPos, projection, viewportHeight);
+        int lod = std::min(std::max(currentLod, 0), LodCount() - 1);
+        while (lod + 1 < LodCount() && radius < switchRadius(lod + 1) * (1.0f - lodHysteresis))
+            lod++;
+        while (lod > 0 && radius > switchRadius(lod) * (1.0f + lodHysteresis))
+            lod--;
+        return lod;
+    }
+
+    // draws only the meshes whose bounds are inside the frustum; model is the same matrix the shader gets.
+    // returns how many meshes were drawn
+    int Draw(Shader &shader, const Frustum &frustum, const glm::mat4 &model, int lod = 0)
+    {
+        int drawn = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if (!frustum.Intersects(meshes[i].aabb.Transformed(model)))
+                continue;
+            meshes[i].Draw(shader, meshes[i].VAO, lod);
+            drawn++;
+        }
+        return drawn;
+    }
+
+    // queues the meshes for RenderQueue::Execute instead of drawing them, culled like Draw when a frustum is given
+    void Enqueue(RenderQueue &queue, RenderQueue::Pass pass, Shader &shader, const glm::mat4 &model, int lod = 0, const Frustum *frustum = nullptr)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if (frustum && !frustum->Intersects(meshes[i].aabb.Transformed(model)))
+                continue;
+            queue.Add(pass, shader, meshes[i], model, lod);
+        }
+    }
+    
+	auto& GetBoneInfoMap() { return m_BoneInfoMap; }
+	int& GetBoneCount() { return m_BoneCounter; }
+
+	// 0 when no vertex is skinned (stones, forest, orbs)
+	int GetMaxInfluences() const
+	{
+		int influences = 0;
+		for (const Mesh& mesh : meshes)
+			influences = std::max(influences, mesh.maxInfluences);
+		return influences;
+	}
+
+	// Bound of the current pose in model space. Every skinned vertex is a weighted average of
+	// its bones' transforms, so it stays inside the union of each bone's bind-pose box moved by
+	// that bone's final matrix. Costs one box transform per bone instead of touching vertices.
+	AABB GetSkinnedBounds(const std::vector<glm::mat4>& finalBoneMatrices) const
+	{
+		AABB bounds = m_UnskinnedBounds;
+		for (size_t id = 0; id < m_BoneBounds.size(); id++)
+		{
+			if (!m_BoneBounds[id].IsValid())
+				continue;
+			if (id < finalBoneMatrices.size())
+				bounds.Expand(m_BoneBounds[id].Transformed(finalBoneMatrices[id]));
+			else
+				bounds.Expand(m_BoneBounds[id]); // outside the palette the shader leaves it in bind pose
+		}
+		return bounds;
+	}
+	
+
+private:
+
+	std::map<string, BoneInfo> m_BoneInfoMap;
+	int m_BoneCounter = 0;
+
+	// bind-pose boxes indexed by bone id, plus the vertices no bone moves
+	std::vector<AABB> m_BoneBounds;
+	AABB m_UnskinnedBounds;
+
+	void reportVertexCache(const string& path)
+	{
+		VertexCacheStats before, after;
+		int shortIndexed = 0;
+		for (const Mesh& mesh : meshes)
+		{
+			before += mesh.cacheBefore;
+			after += mesh.cacheAfter;
+			if (mesh.indexType == GL_UNSIGNED_SHORT)
+				shortIndexed++;
+		}
+		cout << "MODEL::VERTEX_CACHE " << path.substr(path.find_last_of('/') + 1)
+			<< " ACMR " << before.ACMR() << " -> " << after.ACMR()
+			<< ", ATVR " << before.ATVR() << " -> " << after.ATVR()
+			<< ", 16 bit indices on " << shortIndexed << "/" << meshes.size() << " meshes" << endl;
+	}
+
+	// triangles of each level over all meshes, so a level the simplifier couldn't reduce shows up
+	void reportLods(const string& path)
+	{
+		if (lodLevels.empty())
+			return;
+		cout << "MODEL::LOD " << path.substr(path.find_last_of('/') + 1) << " triangles";
+		for (int level = 0; level < LodCount(); level++)
+		{
+			size_t triangles = 0;
+			for (const Mesh& mesh : meshes)
+				triangles += mesh.lods[std::min(level, (int)mesh.lods.size() - 1)].indexCount / 3; // skinned pieces have no levels
+			cout << (level == 0 ? " " : " -> ") << triangles;
+			if (level > 0)
+				cout << " (" << (int)std::lround(lodLevels[level - 1] * 100.0f) << "%)";
+		}
+		cout << endl;
+	}
+
+	static bool sameTextures(const Mesh& a, const Mesh& b)
+	{
+		if (a.textures.size() != b.textures.size())
+			return false;
+		for (size_t i = 0; i < a.textures.size(); i++)
+			if (a.textures[i].id != b.textures[i].id || a.textures[i].type != b.textures[i].type)
+				return false;
+		return true;
+	}
+
+	// first diffuse texture of a mesh, 0 if it has none
+	static GLuint diffuseOf(const Mesh& mesh)
+	{
+		for (const Texture& texture : mesh.textures)
+			if (texture.type == "texture_diffuse")
+				return texture.id;
+		return 0;
+	}
+
+	// One mesh out of several, drawn with the given textures; the originals' GL objects are freed.
+	// Skinned meshes share the union of their palettes, their bone slots are renumbered into it.
+	Mesh mergeMeshes(const vector<size_t>& batch, const vector<Texture>& textures, unsigned int attribs)
+	{
+		vector<Vertex> vertices;
+		vector<unsigned int> indices;
+		vector<int> palette;
+		bool packed = true;
+		for (size_t i : batch)
+		{
+			unsigned int base = (unsigned int)vertices.size();
+			for (Vertex v : meshes[i].vertices)
+			{
+				if (meshes[i].maxInfluences > 0)
+					for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+						if (v.m_Weights[k] > 0.0f)
+							v.m_BoneIDs[k] = paletteSlot(palette, meshes[i].boneRemap[v.m_BoneIDs[k]]);
+				vertices.push_back(v);
+			}
+			for (unsigned int index : meshes[i].indices)
+				indices.push_back(base + index);
+			packed = packed && meshes[i].packed;
+			meshes[i].Release();
+		}
+		Mesh mesh(vertices, indices, textures, packed, attribs, lodLevels);
+		mesh.boneRemap = palette;
+		return mesh;
+	}
+
+	static int paletteSlot(vector<int>& palette, int bone)
+	{
+		auto found = std::find(palette.begin(), palette.end(), bone);
+		if (found != palette.end())
+			return (int)(found - palette.begin());
+		palette.push_back(bone);
+		return (int)palette.size() - 1;
+	}
+
+	// projected radius where level lod (>= 1) takes over
+	float switchRadius(int lod) const
+	{
+		return lodFullDetailRadius * std::sqrt(lodLevels[lod - 1]);
+	}
+
+	void sortByInfluences()
+	{
+		drawOrder.clear();
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			drawOrder.push_back(i);
+		std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](unsigned int a, unsigned int b) {
+			return meshes[a].maxInfluences < meshes[b].maxInfluences;
+		});
+	}
+
+	void computeBounds()
+	{
+		for (const Mesh& mesh : meshes)
+			aabb.Expand(mesh.aabb);
+
+		sphere.center = aabb.IsValid() ? aabb.Center() : glm::vec3(0.0f);
+		sphere.radius = 0.0f;
+		for (const Mesh& mesh : meshes)
+			sphere.radius = std::max(sphere.radius, glm::length(mesh.sphere.center - sphere.center) + mesh.sphere.radius);
+	}
+
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    void loadModel(string const &path)
+    {
+        // read file via ASSIMP
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices);
+        // check for errors
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        {
+            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+            return;
+        }
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // process ASSIMP's root node recursively
+        processNode(scene->mRootNode, scene);
+    }
+
+    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode *node, const aiScene *scene)
+    {
+        // process each mesh located at the current node
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            // the node object only contains indices to index the actual objects in the scene. 
+            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            processMesh(mesh, scene);
+        }
+        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            processNode(node->mChildren[i], scene);
+        }
+
+    }
+
+	void SetVertexBoneDataToDefault(Vertex& vertex)
+	{
+		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+		{
+			vertex.m_BoneIDs[i] = -1;
+			vertex.m_Weights[i] = 0.0f;
+		}
+	}
+
+
+	void processMesh(aiMesh* mesh, const aiScene* scene)
+	{
+		vector<Vertex> vertices;
+		vector<unsigned int> indices;
+		vector<Texture> textures;
+
+		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+		{
+			Vertex vertex;
+			SetVertexBoneDataToDefault(vertex);
+			vertex.Position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
+			vertex.Normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
+			
+			if (mesh->mTextureCoords[0])
+			{
+				glm::vec2 vec;
+				vec.x = mesh->mTextureCoords[0][i].x;
+				vec.y = mesh->mTextureCoords[0][i].y;
+				vertex.TexCoords = vec;
+			}
+			else
+				vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+
+			vertices.push_back(vertex);
+		}
+		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+		{
+			aiFace face = mesh->mFaces[i];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+				indices.push_back(face.mIndices[j]);
+		}
+		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+		vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+		vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+		std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+
+		ExtractBoneWeightForVertices(vertices,mesh,scene);
+		NormalizeBoneWeights(vertices);
+		AccumulateBoneBounds(vertices);
+
+		if (mesh->mNumBones == 0)
+			meshes.push_back(Mesh(vertices, indices, textures, true, vertexAttribs, lodLevels));
+		else
+			AddSkinnedMeshes(vertices, indices, textures);
+	}
+
+	// heaviest influence first, weights summing to 1, so the skinning kernels need no branches or division
+	void NormalizeBoneWeights(std::vector<Vertex>& vertices)
+	{
+		for (Vertex& vertex : vertices)
+		{
+			for (int i = 1; i < MAX_BONE_INFLUENCE; i++)
+			{
+				for (int j = i; j > 0 && vertex.m_Weights[j] > vertex.m_Weights[j - 1]; j--)
+				{
+					std::swap(vertex.m_Weights[j], vertex.m_Weights[j - 1]);
+					std::swap(vertex.m_BoneIDs[j], vertex.m_BoneIDs[j - 1]);
+				}
+			}
+
+			float total = 0.0f;
+			for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+				if (vertex.m_BoneIDs[i] >= 0)
+					total += vertex.m_Weights[i];
+			if (total > 0.0f)
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+					vertex.m_Weights[i] /= total;
+		}
+	}
+
+	// Rewrites model bone ids into compact per-mesh palettes. Triangles are added greedily and a new
+	// mesh is started whenever the next triangle would push the palette past MAX_MESH_BONES.
+	void AddSkinnedMeshes(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures)
+	{
+		std::map<int, int> palette;              // model bone id (-1 = identity) -> local slot
+		std::vector<unsigned int> triangles;     // first index of each triangle in this piece
+
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			int added = 0;
+			int newBones[3 * MAX_BONE_INFLUENCE];
+			for (int k = 0; k < 3; k++)
+			{
+				const Vertex& v = vertices[indices[t + k]];
+				bool any = false;
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+				{
+					if (v.m_BoneIDs[i] < 0 || v.m_Weights[i] <= 0.0f)
+						continue;
+					any = true;
+					if (!palette.count(v.m_BoneIDs[i]) && std::find(newBones, newBones + added, v.m_BoneIDs[i]) == newBones + added)
+						newBones[added++] = v.m_BoneIDs[i];
+				}
+				if (!any && !palette.count(-1) && std::find(newBones, newBones + added, -1) == newBones + added)
+					newBones[added++] = -1;
+			}
+
+			if (!triangles.empty() && palette.size() + added > MAX_MESH_BONES)
+			{
+				FlushSkinnedMesh(vertices, indices, textures, triangles, palette);
+				triangles.clear();
+				palette.clear();
+				t -= 3; // redo this triangle against the empty palette
+				continue;
+			}
+
+			for (int i = 0; i < added; i++)
+			{
+				int slot = (int)palette.size();
+				palette[newBones[i]] = slot;
+			}
+			triangles.push_back((unsigned int)t);
+		}
+
+		if (!triangles.empty())
+			FlushSkinnedMesh(vertices, indices, textures, triangles, palette);
+	}
+
+	void FlushSkinnedMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures,
+		const std::vector<unsigned int>& triangles, const std::map<int, int>& palette)
+	{
+		std::vector<Vertex> pieceVertices;
+		std::vector<unsigned int> pieceIndices;
+		std::map<unsigned int, unsigned int> vertexRemap;
+
+		for (unsigned int first : triangles)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int index = indices[first + k];
+				auto found = vertexRemap.find(index);
+				if (found != vertexRemap.end())
+				{
+					pieceIndices.push_back(found->second);
+					continue;
+				}
+
+				// unused slots point at slot 0 with weight 0 so the shader can always read all of them
+				Vertex v = vertices[index];
+				bool any = false;
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+				{
+					if (v.m_BoneIDs[i] >= 0 && v.m_Weights[i] > 0.0f)
+					{
+						v.m_BoneIDs[i] = palette.at(v.m_BoneIDs[i]);
+						any = true;
+					}
+					else
+					{
+						v.m_BoneIDs[i] = 0;
+						v.m_Weights[i] = 0.0f;
+					}
+				}
+				if (!any)
+				{
+					v.m_BoneIDs[0] = palette.at(-1);
+					v.m_Weights[0] = 1.0f;
+				}
+
+				unsigned int newIndex = (unsigned int)pieceVertices.size();
+				vertexRemap[index] = newIndex;
+				pieceVertices.push_back(v);
+				pieceIndices.push_back(newIndex);
+			}
+		}
+
+		Mesh piece(pieceVertices, pieceIndices, textures, true, vertexAttribs);
+		piece.boneRemap.assign(palette.size(), -1);
+		for (const auto& entry : palette)
+			piece.boneRemap[entry.second] = entry.first;
+		meshes.push_back(piece);
+	}
+
+	void AccumulateBoneBounds(const std::vector<Vertex>& vertices)
+	{
+		for (const Vertex& vertex : vertices)
+		{
+			bool skinned = false;
+			for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+			{
+				int id = vertex.m_BoneIDs[i];
+				if (id < 0 || vertex.m_Weights[i] <= 0.0f)
+					continue;
+				if (id >= (int)m_BoneBounds.size())
+					m_BoneBounds.resize(id + 1);
+				m_BoneBounds[id].Expand(vertex.Position);
+				skinned = true;
+			}
+			if (!skinned)
+				m_UnskinnedBounds.Expand(vertex.Position);
+		}
+	}
+
+	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
+	{
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+		{
+			if (vertex.m_BoneIDs[i] < 0)
+			{
+				vertex.m_Weights[i] = weight;
+				vertex.m_BoneIDs[i] = boneID;
+				return;
+			}
+		}
+
+		// all slots taken: keep the heaviest influences instead of the first ones seen
+		int lightest = 0;
+		for (int i = 1; i < MAX_BONE_INFLUENCE; ++i)
+			if (vertex.m_Weights[i] < vertex.m_Weights[lightest])
+				lightest = i;
+		if (weight > vertex.m_Weights[lightest])
+		{
+			vertex.m_Weights[lightest] = weight;
+			vertex.m_BoneIDs[lightest] = boneID;
+		}
+	}
+
+
+	void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+	{
+		auto& boneInfoMap = m_BoneInfoMap;
+		int& boneCount = m_BoneCounter;
+
+		for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+		{
+			int boneID = -1;
+			std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
+			if (boneInfoMap.find(boneName) == boneInfoMap.end())
+			{
+				BoneInfo newBoneInfo;
+				newBoneInfo.id = boneCount;
+				newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
+				boneInfoMap[boneName] = newBoneInfo;
+				boneID = boneCount;
+				boneCount++;
+			}
+			else
+			{
+				boneID = boneInfoMap[boneName].id;
+			}
+			assert(boneID != -1);
+			auto weights = mesh->mBones[boneIndex]->mWeights;
+			int numWeights = mesh->mBones[boneIndex]->mNumWeights;
+
+			for (int weightIndex = 0; weightIndex < numWeights; ++weightIndex)
+			{
+				int vertexId = weights[weightIndex].mVertexId;
+				float weight = weights[weightIndex].mWeight;
+				assert(vertexId <= vertices.size());
+				SetVertexBoneData(vertices[vertexId], boneID, weight);
+			}
+		}
+	}
+
+
+	unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false)
+	{
+		string filename = string(path);
+		filename = directory + '/' + filename;
+
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+
+		int width, height, nrComponents;
+		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+		if (data)
+		{
+			GLenum format;
+			if (nrComponents == 1)
+				format = GL_RED;
+			else if (nrComponents == 3)
+				format = GL_RGB;
+			else if (nrComponents == 4)
+				format = GL_RGBA;
+
+			MaterialBindings::Invalidate();
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+			glGenerateMipmap(GL_TEXTURE_2D);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			stbi_image_free(data);
+		}
+		else
+		{
+			std::cout << "Texture failed to load at path: " << path << std::endl;
+			stbi_image_free(data);
+		}
+
+		return textureID;
+	}
+    
+    // checks all material textures of a given type and loads the textures if they're not loaded yet.
+    // the required info is returned as a Texture struct.
+    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    {
+        vector<Texture> textures;
+        for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+        {
+            aiString str;
+            mat->GetTexture(type, i, &str);
+            // check if texture was loaded before and if so, continue to next iteration and skip loading a new texture
+            bool skip = false;
+            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            {
+                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                {
+                    textures.push_back(textures_loaded[j]);
+                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
+                    break;
+                }
+            }
+            if(!skip)
+            {   // if texture hasn't been loaded already, load it
+                Texture texture;
+                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                texture.type = typeName;
+                texture.path = str.C_Str();
+                textures.push_back(texture);
+                textures_loaded.push_back(texture); // store it in model, to prevent unnecessary load of textures
+            }
+        }
+        return textures;
+    }
+};
+
+
+
+#endif
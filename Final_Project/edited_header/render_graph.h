@@ -0,0 +1,391 @@
+// Frame passes declared with what they read and write, instead of framebuffers managed by hand in main().
+// Every frame the program Begin()s the graph, Create()s the transient textures it needs (size + format),
+// adds its passes in the order they should run and calls Execute(), which
+//  - culls passes whose outputs nobody reads: walking back from the passes that write the Backbuffer,
+//    a pass only survives if a later surviving pass reads something it writes,
+//  - gives every transient texture a lifetime (first to last surviving pass using it) and maps it onto
+//    a pooled GL texture of the same size and format whose previous user is already done, so targets
+//    that are never alive at the same time share memory (a chain of passes ping-pongs between two),
+//  - binds a framebuffer with the pass's writes (cached per attachment set) and sets the viewport
+//    before running the pass.
+// Pool textures and framebuffers outlive the frame and are only released after a few frames unused
+// (e.g. after a resize), so a steady frame allocates nothing.
+// A pass that writes a texture without reading it must overwrite (or clear) all of it; the texture may
+// still hold another target's pixels.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <learnopengl/material.h>
+
+class RenderGraph
+{
+public:
+	typedef int Resource;
+	static const Resource Backbuffer = 0; // the default framebuffer, always there
+
+	struct TextureDesc {
+		int width;
+		int height;
+		GLenum internalFormat; // GL_RGBA8, GL_RGBA16F, GL_R11F_G11F_B10F, GL_DEPTH_COMPONENT24, ...
+
+		bool operator==(const TextureDesc& other) const
+		{
+			return width == other.width && height == other.height && internalFormat == other.internalFormat;
+		}
+	};
+
+	// what the last Execute() did
+	struct Stats {
+		unsigned int passes = 0;
+		unsigned int culledPasses = 0;
+		unsigned int transientTextures = 0; // created this frame and used by a surviving pass
+		unsigned int pooledTextures = 0;    // GL textures behind them
+		size_t pooledBytes = 0;
+	};
+
+	RenderGraph() = default;
+
+	~RenderGraph()
+	{
+		for (Framebuffer& framebuffer : m_Framebuffers)
+			glDeleteFramebuffers(1, &framebuffer.fbo);
+		for (PoolTexture& texture : m_Pool)
+			glDeleteTextures(1, &texture.texture);
+		if (m_EmptyVAO != 0)
+			glDeleteVertexArrays(1, &m_EmptyVAO);
+	}
+
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// starts a frame; width / height: size of the default framebuffer
+	void Begin(int width, int height)
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		ResourceNode backbuffer;
+		backbuffer.name = "backbuffer";
+		backbuffer.desc = TextureDesc{ width, height, GL_RGBA8 };
+		m_Resources.push_back(backbuffer);
+	}
+
+	// a texture that only lives within this frame
+	Resource Create(const std::string& name, const TextureDesc& desc)
+	{
+		ResourceNode resource;
+		resource.name = name;
+		resource.desc = desc;
+		resource.desc.width = std::max(desc.width, 1); // minimized window
+		resource.desc.height = std::max(desc.height, 1);
+		m_Resources.push_back(resource);
+		return (Resource)m_Resources.size() - 1;
+	}
+
+	const TextureDesc& Desc(Resource resource) const { return m_Resources[resource].desc; }
+
+	// execute runs with the pass's framebuffer bound and the viewport set to its size. Writes are the
+	// color attachments in order and at most one depth texture; the Backbuffer can't be mixed with others.
+	void AddPass(const std::string& name, std::initializer_list<Resource> reads, std::initializer_list<Resource> writes,
+		std::function<void()> execute)
+	{
+		PassNode pass;
+		pass.name = name;
+		pass.reads.assign(reads.begin(), reads.end());
+		pass.writes.assign(writes.begin(), writes.end());
+		pass.execute = std::move(execute);
+		m_Passes.push_back(std::move(pass));
+	}
+
+	// GL texture of a transient resource, valid inside the passes that read or write it
+	GLuint Texture(Resource resource) const { return m_Resources[resource].texture; }
+
+	// culls, allocates, runs the passes and leaves the default framebuffer bound
+	void Execute()
+	{
+		cull();
+		allocate();
+
+		for (PassNode& pass : m_Passes)
+		{
+			if (pass.culled)
+				continue;
+			const TextureDesc& target = m_Resources[pass.writes.empty() ? Backbuffer : pass.writes[0]].desc;
+			glBindFramebuffer(GL_FRAMEBUFFER, framebufferFor(pass));
+			glViewport(0, 0, target.width, target.height);
+			pass.execute();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, m_Resources[Backbuffer].desc.width, m_Resources[Backbuffer].desc.height);
+
+		m_Passes.clear(); // executes hold references that may not outlive the frame
+	}
+
+	// a triangle covering the viewport (gl_VertexID based, see post.vs), depth test off while it draws
+	void DrawFullscreenTriangle()
+	{
+		if (m_EmptyVAO == 0)
+			glGenVertexArrays(1, &m_EmptyVAO); // core profile won't draw without a vertex array
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_TEST);
+		glBindVertexArray(m_EmptyVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+		if (depthTest)
+			glEnable(GL_DEPTH_TEST);
+	}
+
+	const Stats& LastStats() const { return m_Stats; }
+
+private:
+	struct ResourceNode {
+		std::string name;
+		TextureDesc desc;
+		int firstPass = -1; // lifetime among the surviving passes
+		int lastPass = -1;
+		GLuint texture = 0;
+	};
+
+	struct PassNode {
+		std::string name;
+		std::vector<Resource> reads;
+		std::vector<Resource> writes;
+		std::function<void()> execute;
+		bool culled = false;
+	};
+
+	struct PoolTexture {
+		TextureDesc desc;
+		GLuint texture;
+		int busyUntil;      // last pass of the resource mapped onto it this frame, -1 = free
+		int idleFrames;
+	};
+
+	struct Framebuffer {
+		std::vector<GLuint> attachments; // colors..., then the depth texture (0 if none)
+		GLuint fbo;
+		int idleFrames;
+	};
+
+	static const int kReleaseAfterFrames = 3;
+
+	std::vector<ResourceNode> m_Resources;
+	std::vector<PassNode> m_Passes;
+	std::vector<PoolTexture> m_Pool;
+	std::vector<Framebuffer> m_Framebuffers;
+	GLuint m_EmptyVAO = 0;
+	Stats m_Stats;
+
+	static bool isDepthFormat(GLenum format)
+	{
+		return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F
+			|| format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+	}
+
+	static size_t bytesPerTexel(GLenum format)
+	{
+		switch (format)
+		{
+		case GL_RGBA16F: case GL_DEPTH32F_STENCIL8: return 8;
+		case GL_RGBA32F: return 16;
+		case GL_RG16F: case GL_R32F: return 4;
+		case GL_R8: return 1;
+		case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+		default: return 4; // RGBA8, R11F_G11F_B10F, RGB10_A2, DEPTH_COMPONENT24 / 32F, DEPTH24_STENCIL8
+		}
+	}
+
+	// Backwards from the last pass: a pass is needed if it writes the Backbuffer or something a later
+	// needed pass reads. What a needed pass overwrites without reading is dead before it.
+	void cull()
+	{
+		std::vector<bool> needed(m_Resources.size(), false);
+		needed[Backbuffer] = true;
+		m_Stats = Stats();
+		m_Stats.passes = (unsigned int)m_Passes.size();
+		for (int i = (int)m_Passes.size() - 1; i >= 0; i--)
+		{
+			PassNode& pass = m_Passes[i];
+			pass.culled = true;
+			for (Resource write : pass.writes)
+				if (needed[write])
+					pass.culled = false;
+			if (pass.culled)
+			{
+				m_Stats.culledPasses++;
+				continue;
+			}
+			for (Resource write : pass.writes)
+				if (write != Backbuffer)
+					needed[write] = false;
+			for (Resource read : pass.reads)
+				needed[read] = true;
+		}
+	}
+
+	// lifetimes of the transient textures, then each one onto a free pool texture of its size and format
+	void allocate()
+	{
+		for (int i = 0; i < (int)m_Passes.size(); i++)
+		{
+			if (m_Passes[i].culled)
+				continue;
+			for (const std::vector<Resource>* list : { &m_Passes[i].reads, &m_Passes[i].writes })
+				for (Resource resource : *list)
+				{
+					ResourceNode& node = m_Resources[resource];
+					if (node.firstPass < 0)
+						node.firstPass = i;
+					node.lastPass = std::max(node.lastPass, i);
+				}
+		}
+
+		for (PoolTexture& texture : m_Pool)
+			texture.busyUntil = -1;
+		// first use order, so a texture freed by one resource is picked up by the next one
+		for (int i = 0; i < (int)m_Passes.size(); i++)
+			for (size_t r = 1; r < m_Resources.size(); r++)
+			{
+				ResourceNode& node = m_Resources[r];
+				if (node.firstPass != i)
+					continue;
+				PoolTexture* match = nullptr;
+				for (PoolTexture& texture : m_Pool)
+					if (texture.desc == node.desc && texture.busyUntil < i)
+					{
+						match = &texture;
+						break;
+					}
+				if (match == nullptr)
+				{
+					m_Pool.push_back(PoolTexture{ node.desc, createTexture(node.desc), -1, 0 });
+					match = &m_Pool.back();
+				}
+				match->busyUntil = node.lastPass;
+				node.texture = match->texture;
+				m_Stats.transientTextures++;
+			}
+
+		// textures left out for a few frames (old window size, a pass turned off) go back to the driver
+		for (size_t i = 0; i < m_Pool.size();)
+		{
+			PoolTexture& texture = m_Pool[i];
+			texture.idleFrames = texture.busyUntil >= 0 ? 0 : texture.idleFrames + 1;
+			if (texture.idleFrames > kReleaseAfterFrames)
+			{
+				releaseFramebuffersOf(texture.texture);
+				glDeleteTextures(1, &texture.texture);
+				m_Pool.erase(m_Pool.begin() + i);
+				continue;
+			}
+			m_Stats.pooledTextures++;
+			m_Stats.pooledBytes += (size_t)texture.desc.width * texture.desc.height * bytesPerTexel(texture.desc.internalFormat);
+			i++;
+		}
+		for (size_t i = 0; i < m_Framebuffers.size();)
+		{
+			if (++m_Framebuffers[i].idleFrames > kReleaseAfterFrames)
+			{
+				glDeleteFramebuffers(1, &m_Framebuffers[i].fbo);
+				m_Framebuffers.erase(m_Framebuffers.begin() + i);
+				continue;
+			}
+			i++;
+		}
+	}
+
+	GLuint createTexture(const TextureDesc& desc)
+	{
+		GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+		if (desc.internalFormat == GL_DEPTH24_STENCIL8)
+			format = GL_DEPTH_STENCIL, type = GL_UNSIGNED_INT_24_8;
+		else if (desc.internalFormat == GL_DEPTH32F_STENCIL8)
+			format = GL_DEPTH_STENCIL, type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+		else if (isDepthFormat(desc.internalFormat))
+			format = GL_DEPTH_COMPONENT, type = GL_FLOAT;
+
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, format, type, NULL);
+		GLint filter = isDepthFormat(desc.internalFormat) ? GL_NEAREST : GL_LINEAR;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		MaterialBindings::Invalidate();
+		return texture;
+	}
+
+	GLuint framebufferFor(const PassNode& pass)
+	{
+		std::vector<GLuint> attachments;
+		GLuint depth = 0;
+		for (Resource write : pass.writes)
+		{
+			if (write == Backbuffer)
+				return 0;
+			if (isDepthFormat(m_Resources[write].desc.internalFormat))
+				depth = m_Resources[write].texture;
+			else
+				attachments.push_back(m_Resources[write].texture);
+		}
+		attachments.push_back(depth);
+
+		for (Framebuffer& framebuffer : m_Framebuffers)
+			if (framebuffer.attachments == attachments)
+			{
+				framebuffer.idleFrames = 0;
+				return framebuffer.fbo;
+			}
+
+		Framebuffer framebuffer;
+		framebuffer.attachments = attachments;
+		framebuffer.idleFrames = 0;
+		glGenFramebuffers(1, &framebuffer.fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+		std::vector<GLenum> drawBuffers;
+		for (size_t i = 0; i + 1 < attachments.size(); i++)
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, attachments[i], 0);
+			drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+		}
+		if (depth != 0)
+		{
+			bool stencil = false;
+			for (Resource write : pass.writes)
+				if (m_Resources[write].texture == depth)
+					stencil = m_Resources[write].desc.internalFormat == GL_DEPTH24_STENCIL8 || m_Resources[write].desc.internalFormat == GL_DEPTH32F_STENCIL8;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+		}
+		if (drawBuffers.empty())
+			glDrawBuffer(GL_NONE);
+		else
+			glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::RENDER_GRAPH:: framebuffer of pass " << pass.name << " is not complete" << std::endl;
+		m_Framebuffers.push_back(framebuffer);
+		return framebuffer.fbo;
+	}
+
+	void releaseFramebuffersOf(GLuint texture)
+	{
+		for (size_t i = 0; i < m_Framebuffers.size();)
+		{
+			if (std::find(m_Framebuffers[i].attachments.begin(), m_Framebuffers[i].attachments.end(), texture) != m_Framebuffers[i].attachments.end())
+			{
+				glDeleteFramebuffers(1, &m_Framebuffers[i].fbo);
+				m_Framebuffers.erase(m_Framebuffers.begin() + i);
+				continue;
+			}
+			i++;
+		}
+	}
+};
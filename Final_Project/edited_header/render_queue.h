@@ -0,0 +1,213 @@
+// Draws collected for a frame and sent in state order instead of code order.
+// Every submission becomes a command with a 64 bit sort key: pass, program, material, vertex array,
+// then view depth (front to back, so opaque surfaces hidden behind nearer ones fail the depth test
+// before shading). Execute() sorts the keys and only touches GL state that actually changes between
+// neighbours: a program switch, a texture set, a vertex array, a model matrix.
+// Commands that need more than a model matrix (bone palettes, indirect batches, quads with their own
+// textures) are added as custom draws; the queue assumes nothing about the state they leave behind.
+// Uniforms that are the same for the whole frame (camera, lights) are set on the programs before
+// Execute(); per-draw ones are "model" and, when the program has it, "normalMatrix".
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <learnopengl/mesh.h>
+
+class RenderQueue
+{
+public:
+	// executed in this order; Transparent sorts back to front before any state
+	enum Pass {
+		Opaque = 0,
+		Background = 1,  // full screen backdrops behind everything, drawn once the depth buffer is filled
+		Transparent = 2
+	};
+
+	// what the last Execute() did, to compare with the command count
+	struct Stats {
+		unsigned int commands = 0;
+		unsigned int programChanges = 0;
+		unsigned int vertexArrayChanges = 0;
+		unsigned int matrixUploads = 0;
+	};
+
+	// view: camera of the frame (for the depth part of the keys); farPlane: depth that maps to the last key
+	void Begin(const glm::mat4& view, float farPlane)
+	{
+		m_DepthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+		m_FarPlane = farPlane;
+		m_Commands.clear();
+		m_Order.clear();
+		m_Transforms.clear();
+	}
+
+	// one indexed mesh; vao 0 draws from the mesh's own (another one: e.g. a skin prepass target)
+	void Add(Pass pass, const Shader& shader, const Mesh& mesh, const glm::mat4& model, int lod = 0, GLuint vao = 0)
+	{
+		Command command;
+		command.program = shader.ID;
+		command.mesh = &mesh;
+		command.material = &mesh.material;
+		command.vao = vao != 0 ? vao : mesh.VAO;
+		command.lod = lod;
+		command.transform = addTransform(model);
+		push(pass, command, glm::vec3(model * glm::vec4(mesh.aabb.Center(), 1.0f)));
+	}
+
+	// glDrawArrays(mode, first, count) from vao, e.g. plain cube or quad buffers
+	void AddArrays(Pass pass, const Shader& shader, GLuint vao, GLenum mode, GLint first, GLsizei count,
+		const glm::mat4& model, const Material* material = nullptr)
+	{
+		Command command;
+		command.program = shader.ID;
+		command.material = material;
+		command.vao = vao;
+		command.mode = mode;
+		command.first = first;
+		command.count = count;
+		command.transform = addTransform(model);
+		push(pass, command, glm::vec3(model[3]));
+	}
+
+	// anything else; draw() runs with shader in use and may change any state. center: for the depth order
+	void AddCustom(Pass pass, const Shader& shader, const glm::vec3& center, std::function<void()> draw)
+	{
+		Command command;
+		command.program = shader.ID;
+		command.draw = std::move(draw);
+		push(pass, command, center);
+	}
+
+	// sorts and draws everything added since Begin()
+	void Execute()
+	{
+		std::sort(m_Order.begin(), m_Order.end());
+
+		m_Stats = Stats();
+		m_Stats.commands = (unsigned int)m_Order.size();
+		const GLuint unknown = ~0u;
+		GLuint program = unknown, vao = unknown;
+		uint32_t transform = ~0u;
+		const ProgramUniforms* uniforms = nullptr;
+		for (const std::pair<uint64_t, uint32_t>& entry : m_Order)
+		{
+			const Command& command = m_Commands[entry.second];
+			if (command.program != program)
+			{
+				glUseProgram(command.program);
+				program = command.program;
+				uniforms = &uniformsOf(program);
+				transform = ~0u; // the matrices are per program
+				m_Stats.programChanges++;
+			}
+			if (command.draw)
+			{
+				command.draw();
+				program = vao = unknown;
+				continue;
+			}
+			if (command.material)
+				command.material->Bind(program);
+			if (command.vao != vao)
+			{
+				glBindVertexArray(command.vao);
+				vao = command.vao;
+				m_Stats.vertexArrayChanges++;
+			}
+			if (command.transform != transform)
+			{
+				const glm::mat4& model = m_Transforms[command.transform];
+				if (uniforms->model >= 0)
+					glUniformMatrix4fv(uniforms->model, 1, GL_FALSE, &model[0][0]);
+				if (uniforms->normalMatrix >= 0)
+				{
+					glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+					glUniformMatrix3fv(uniforms->normalMatrix, 1, GL_FALSE, &normalMatrix[0][0]);
+				}
+				transform = command.transform;
+				m_Stats.matrixUploads++;
+			}
+			if (command.mesh)
+				command.mesh->DrawBound(command.vao, command.lod);
+			else
+				glDrawArrays(command.mode, command.first, command.count);
+		}
+		glBindVertexArray(0);
+
+		m_Commands.clear(); // custom draws hold references that may not outlive the frame
+		m_Order.clear();
+		m_Transforms.clear();
+	}
+
+	const Stats& LastStats() const { return m_Stats; }
+
+private:
+	struct Command {
+		GLuint program = 0;
+		const Mesh* mesh = nullptr;         // indexed draw, otherwise glDrawArrays
+		const Material* material = nullptr;
+		GLuint vao = 0;
+		int lod = 0;
+		GLenum mode = GL_TRIANGLES;
+		GLint first = 0;
+		GLsizei count = 0;
+		uint32_t transform = 0;
+		std::function<void()> draw;         // custom command
+	};
+
+	struct ProgramUniforms {
+		GLuint program;
+		GLint model;
+		GLint normalMatrix;
+	};
+
+	std::vector<Command> m_Commands;
+	std::vector<std::pair<uint64_t, uint32_t>> m_Order; // key, command
+	std::vector<glm::mat4> m_Transforms;
+	std::vector<ProgramUniforms> m_Uniforms;
+	glm::vec4 m_DepthRow = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+	float m_FarPlane = 100.0f;
+	Stats m_Stats;
+
+	uint32_t addTransform(const glm::mat4& model)
+	{
+		// consecutive meshes of one model share their matrix
+		if (m_Transforms.empty() || !(m_Transforms.back() == model))
+			m_Transforms.push_back(model);
+		return (uint32_t)m_Transforms.size() - 1;
+	}
+
+	void push(Pass pass, Command& command, const glm::vec3& center)
+	{
+		float depth = glm::dot(m_DepthRow, glm::vec4(center, 1.0f));
+		GLuint material = command.material ? command.material->SortKey() : 0;
+		m_Order.push_back(std::make_pair(makeKey(pass, command.program, material, command.vao, depth), (uint32_t)m_Commands.size()));
+		m_Commands.push_back(std::move(command));
+	}
+
+	// 2 bits pass | 10 program | 16 material | 12 vertex array | 24 depth (most significant first);
+	// Transparent moves the depth, reversed, right after the pass
+	uint64_t makeKey(Pass pass, GLuint program, GLuint material, GLuint vao, float depth) const
+	{
+		uint64_t depthBits = (uint64_t)(std::min(std::max(depth / m_FarPlane, 0.0f), 1.0f) * 0xFFFFFF);
+		uint64_t state = ((uint64_t)(program & 0x3FF) << 28) | ((uint64_t)(material & 0xFFFF) << 12) | (vao & 0xFFF);
+		if (pass == Transparent)
+			return ((uint64_t)pass << 62) | ((0xFFFFFF - depthBits) << 38) | state;
+		return ((uint64_t)pass << 62) | (state << 24) | depthBits;
+	}
+
+	const ProgramUniforms& uniformsOf(GLuint program)
+	{
+		for (const ProgramUniforms& uniforms : m_Uniforms)
+			if (uniforms.program == program)
+				return uniforms;
+		m_Uniforms.push_back(ProgramUniforms{ program, glGetUniformLocation(program, "model"), glGetUniformLocation(program, "normalMatrix") });
+		return m_Uniforms.back();
+	}
+};
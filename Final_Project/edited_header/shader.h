@@ -0,0 +1,368 @@
+// Edited from LearnOpenGL shader.h
+// - optional list of #defines injected after #version, so one source file can be compiled into variants
+// - #include "file" lines are replaced by that file (path relative to the including shader), so
+//   shared GLSL such as clustered_lighting.glsl lives in one place
+// - vertex-only programs that write their outputs to a buffer with transform feedback
+// - uniform locations reflected once after linking; set* look names up in that table, and Uniform<T>
+//   handles skip the lookup entirely
+// - uniform blocks bound by name to binding points shared by all programs (see BlockBinding)
+
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+
+class Shader
+{
+public:
+    unsigned int ID;
+    // constructor generates the shader on the fly
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    {
+        build(vertexPath, fragmentPath, geometryPath, std::vector<std::string>(), std::vector<const char*>());
+    }
+    // same as above, but every entry of defines ("NAME VALUE") becomes a #define in both stages
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines)
+    {
+        build(vertexPath, fragmentPath, nullptr, defines, std::vector<const char*>());
+    }
+    // vertex shader only; the listed outputs are captured interleaved by transform feedback
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const std::vector<std::string>& defines, const std::vector<const char*>& feedbackVaryings)
+    {
+        build(vertexPath, nullptr, nullptr, defines, feedbackVaryings);
+    }
+    // location of a uniform handle, looked up once and typed so set() calls the matching glUniform
+    template <typename T>
+    struct Uniform { GLint location = -1; };
+
+    // binding point of a uniform block, the same in every program (assigned in order of first use)
+    // ------------------------------------------------------------------------
+    static GLuint BlockBinding(const std::string &block)
+    {
+        static std::vector<std::string> blocks;
+        for (size_t i = 0; i < blocks.size(); i++)
+            if (blocks[i] == block)
+                return (GLuint)i;
+        blocks.push_back(block);
+        return (GLuint)blocks.size() - 1;
+    }
+    // activate the shader
+    // ------------------------------------------------------------------------
+    void use() 
+    { 
+        glUseProgram(ID); 
+    }
+    // cached location of an active uniform, -1 if the program doesn't use it
+    // ------------------------------------------------------------------------
+    GLint Location(const std::string &name) const
+    {
+        auto found = m_Locations.find(name);
+        return found == m_Locations.end() ? -1 : found->second;
+    }
+    template <typename T>
+    Uniform<T> GetUniform(const std::string &name) const
+    {
+        Uniform<T> uniform;
+        uniform.location = Location(name);
+        return uniform;
+    }
+    // handle versions of the setters, no lookup at all
+    // ------------------------------------------------------------------------
+    void set(Uniform<int> uniform, int value) const { glUniform1i(uniform.location, value); }
+    void set(Uniform<float> uniform, float value) const { glUniform1f(uniform.location, value); }
+    void set(Uniform<glm::vec3> uniform, const glm::vec3 &value) const { glUniform3fv(uniform.location, 1, &value[0]); }
+    void set(Uniform<glm::vec4> uniform, const glm::vec4 &value) const { glUniform4fv(uniform.location, 1, &value[0]); }
+    void set(Uniform<glm::mat3> uniform, const glm::mat3 &mat) const { glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]); }
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &mat) const { glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]); }
+    // utility uniform functions
+    // ------------------------------------------------------------------------
+    void setBool(const std::string &name, bool value) const
+    {         
+        glUniform1i(Location(name), (int)value); 
+    }
+    // ------------------------------------------------------------------------
+    void setInt(const std::string &name, int value) const
+    { 
+        glUniform1i(Location(name), value); 
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string &name, float value) const
+    { 
+        glUniform1f(Location(name), value); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec2(const std::string &name, const glm::vec2 &value) const
+    { 
+        glUniform2fv(Location(name), 1, &value[0]); 
+    }
+    void setVec2(const std::string &name, float x, float y) const
+    { 
+        glUniform2f(Location(name), x, y); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(const std::string &name, const glm::vec3 &value) const
+    { 
+        glUniform3fv(Location(name), 1, &value[0]); 
+    }
+    void setVec3(const std::string &name, float x, float y, float z) const
+    { 
+        glUniform3f(Location(name), x, y, z); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec4(const std::string &name, const glm::vec4 &value) const
+    { 
+        glUniform4fv(Location(name), 1, &value[0]); 
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    { 
+        glUniform4f(Location(name), x, y, z, w); 
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(Location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(Location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(Location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+private:
+    std::unordered_map<std::string, GLint> m_Locations;
+
+    // reads, compiles and links the program
+    // ------------------------------------------------------------------------
+    void build(const char* vertexPath, const char* fragmentPath, const char* geometryPath,
+        const std::vector<std::string>& defines, const std::vector<const char*>& feedbackVaryings)
+    {
+        // 1. retrieve the vertex/fragment source code from filePath
+        std::string vertexCode;
+        std::string fragmentCode;
+        std::string geometryCode;
+        std::ifstream vShaderFile;
+        std::ifstream fShaderFile;
+        std::ifstream gShaderFile;
+        // ensure ifstream objects can throw exceptions:
+        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try 
+        {
+            // open files
+            vShaderFile.open(vertexPath);
+            std::stringstream vShaderStream;
+            // read file's buffer contents into streams
+            vShaderStream << vShaderFile.rdbuf();
+            // close file handlers
+            vShaderFile.close();
+            // convert stream into string
+            vertexCode = vShaderStream.str();
+            // transform feedback programs have no fragment stage
+            if(fragmentPath != nullptr)
+            {
+                fShaderFile.open(fragmentPath);
+                std::stringstream fShaderStream;
+                fShaderStream << fShaderFile.rdbuf();
+                fShaderFile.close();
+                fragmentCode = fShaderStream.str();
+            }
+            // if geometry shader path is present, also load a geometry shader
+            if(geometryPath != nullptr)
+            {
+                gShaderFile.open(geometryPath);
+                std::stringstream gShaderStream;
+                gShaderStream << gShaderFile.rdbuf();
+                gShaderFile.close();
+                geometryCode = gShaderStream.str();
+            }
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        }
+        vertexCode = expandIncludes(vertexCode, vertexPath);
+        if(fragmentPath != nullptr)
+            fragmentCode = expandIncludes(fragmentCode, fragmentPath);
+        if(geometryPath != nullptr)
+            geometryCode = expandIncludes(geometryCode, geometryPath);
+        vertexCode = injectDefines(vertexCode, defines);
+        fragmentCode = injectDefines(fragmentCode, defines);
+        geometryCode = injectDefines(geometryCode, defines);
+        const char* vShaderCode = vertexCode.c_str();
+        const char * fShaderCode = fragmentCode.c_str();
+        // 2. compile shaders
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        if(fragmentPath != nullptr)
+        {
+            fragment = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragment, 1, &fShaderCode, NULL);
+            glCompileShader(fragment);
+            checkCompileErrors(fragment, "FRAGMENT");
+        }
+        // if geometry shader is given, compile geometry shader
+        unsigned int geometry;
+        if(geometryPath != nullptr)
+        {
+            const char * gShaderCode = geometryCode.c_str();
+            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glCompileShader(geometry);
+            checkCompileErrors(geometry, "GEOMETRY");
+        }
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        if(fragmentPath != nullptr)
+            glAttachShader(ID, fragment);
+        if(geometryPath != nullptr)
+            glAttachShader(ID, geometry);
+        // has to be set before linking
+        if(!feedbackVaryings.empty())
+            glTransformFeedbackVaryings(ID, (GLsizei)feedbackVaryings.size(), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        reflectUniforms();
+        // delete the shaders as they're linked into our program now and no longer necessary
+        glDeleteShader(vertex);
+        if(fragmentPath != nullptr)
+            glDeleteShader(fragment);
+        if(geometryPath != nullptr)
+            glDeleteShader(geometry);
+    }
+    // fills m_Locations with every active uniform and points the uniform blocks at their shared bindings
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> name(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; i++)
+        {
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+            GLint location = glGetUniformLocation(ID, name.data());
+            if (location < 0)
+                continue; // member of a uniform block
+            std::string uniform = name.data();
+            m_Locations[uniform] = location;
+            // arrays are reported as "name[0]", but are set through "name" as well
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+                m_Locations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+
+        GLint blocks = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+        for (GLint i = 0; i < blocks; i++)
+        {
+            GLchar block[256];
+            glGetActiveUniformBlockName(ID, (GLuint)i, sizeof(block), NULL, block);
+            glUniformBlockBinding(ID, (GLuint)i, BlockBinding(block));
+        }
+    }
+    // GLSL has no #include: each '#include "name"' line becomes the named file, read from the
+    // directory of path (included files may include others)
+    // ------------------------------------------------------------------------
+    static std::string expandIncludes(const std::string& code, const std::string& path)
+    {
+        const std::string directive = "#include \"";
+        if (code.find(directive) == std::string::npos)
+            return code;
+
+        size_t slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        std::stringstream in(code);
+        std::string result, line;
+        while (std::getline(in, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, directive.size(), directive) != 0)
+            {
+                result += line + "\n";
+                continue;
+            }
+            size_t nameStart = start + directive.size();
+            std::string includePath = directory + line.substr(nameStart, line.find('"', nameStart) - nameStart);
+            std::ifstream file(includePath);
+            if (!file)
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << includePath << std::endl;
+                continue;
+            }
+            std::stringstream included;
+            included << file.rdbuf();
+            result += expandIncludes(included.str(), includePath) + "\n";
+        }
+        return result;
+    }
+    // #version has to stay the first statement, so the defines go on the line after it
+    // ------------------------------------------------------------------------
+    static std::string injectDefines(const std::string& code, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+            return code;
+
+        std::string block;
+        for (const std::string& define : defines)
+            block += "#define " + define + "\n";
+
+        size_t version = code.find("#version");
+        if (version == std::string::npos)
+            return block + code;
+        size_t lineEnd = code.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return code + "\n" + block;
+        return code.substr(0, lineEnd + 1) + block + code.substr(lineEnd + 1);
+    }
+    // utility function for checking shader compilation/linking errors.
+    // ------------------------------------------------------------------------
+    void checkCompileErrors(GLuint shader, std::string type)
+    {
+        GLint success;
+        GLchar infoLog[1024];
+        if(type != "PROGRAM")
+        {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if(!success)
+            {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else
+        {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if(!success)
+            {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,225 @@
+// Sun shadows split into two depth maps with their own update rates.
+// The static map holds the casters that never move on their own (stones, forest). It covers a box
+// the caller moves in whole steps along the course and is only redrawn when that box, the light or
+// the caster set (a version number the caller bumps) changes, so the big meshes are rendered into
+// it every few seconds instead of every frame.
+// The dynamic map is small, covers a tight box around the player and is redrawn every frame with the
+// moving casters only (the skinned character, orbs). Receivers take the darker of the two lookups.
+// Both matrices live in the ShadowBlock uniform block, the maps are sampler2DShadow on two fixed
+// units; every receiving program has to be Attach()ed (see ShadowVisibility() in anim_model.fs).
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <learnopengl/shader.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/material.h>
+
+class ShadowMaps
+{
+public:
+	// blockBinding: uniform buffer binding of ShadowBlock, firstUnit: unit of the static map (dynamic one follows)
+	ShadowMaps(GLuint blockBinding, int staticSize = 2048, int dynamicSize = 1024, GLuint firstUnit = MaterialBindings::kShadowUnit)
+		: m_Binding(blockBinding), m_FirstUnit(firstUnit)
+	{
+		m_Maps[0].size = staticSize;
+		m_Maps[1].size = dynamicSize;
+		for (Map& map : m_Maps)
+			createMap(map);
+		MaterialBindings::Invalidate();
+
+		// strength 0 until SetLight: attached programs draw unshadowed before the first pass
+		m_Block.staticLightSpace = glm::mat4(1.0f);
+		m_Block.dynamicLightSpace = glm::mat4(1.0f);
+		m_Block.params = glm::vec4(0.0f);
+		glGenBuffers(1, &m_UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &m_Block, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	~ShadowMaps()
+	{
+		glDeleteBuffers(1, &m_UBO);
+		for (Map& map : m_Maps)
+		{
+			glDeleteFramebuffers(1, &map.fbo);
+			glDeleteTextures(1, &map.texture);
+		}
+	}
+
+	ShadowMaps(const ShadowMaps&) = delete;
+	ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+	// Binds the program's ShadowBlock and points its shadow samplers at the units; leaves the program in use
+	void Attach(GLuint program) const
+	{
+		GLuint block = glGetUniformBlockIndex(program, "ShadowBlock");
+		if (block == GL_INVALID_INDEX)
+		{
+			std::cout << "ERROR::SHADOW_MAPS:: program " << program << " has no ShadowBlock" << std::endl;
+			return;
+		}
+		glUniformBlockBinding(program, block, m_Binding);
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "staticShadowMap"), (GLint)m_FirstUnit);
+		glUniform1i(glGetUniformLocation(program, "dynamicShadowMap"), (GLint)(m_FirstUnit + 1));
+	}
+
+	// direction the light travels; strength: share of the light a shadow takes away.
+	// A new direction invalidates the static map.
+	void SetLight(const glm::vec3& direction, float strength)
+	{
+		glm::vec3 unit = glm::normalize(direction);
+		if (!(unit == m_Direction))
+			m_StaticValid = false;
+		m_Direction = unit;
+		m_Block.params.z = strength;
+		m_BlockDirty = true;
+	}
+
+	// Starts the static pass if box or casterVersion differ from the cached map (or the light changed):
+	// binds its framebuffer, clears it and sets lightSpace on depthShader. Returns false when the cached
+	// map is still good, then nothing has to be drawn and End() must not be called.
+	bool BeginStatic(const AABB& box, uint64_t casterVersion, Shader& depthShader)
+	{
+		if (m_StaticValid && casterVersion == m_StaticVersion && box.min == m_StaticBox.min && box.max == m_StaticBox.max)
+			return false;
+		m_StaticValid = true;
+		m_StaticVersion = casterVersion;
+		m_StaticBox = box;
+		m_Block.staticLightSpace = fit(box, m_Maps[0].size, m_Block.params.x);
+		begin(m_Maps[0], m_Block.staticLightSpace, depthShader);
+		m_StaticRenders++;
+		return true;
+	}
+
+	// Starts the per-frame pass of the moving casters inside box, like BeginStatic
+	void BeginDynamic(const AABB& box, Shader& depthShader)
+	{
+		m_Block.dynamicLightSpace = fit(box, m_Maps[1].size, m_Block.params.y);
+		begin(m_Maps[1], m_Block.dynamicLightSpace, depthShader);
+	}
+
+	// back to the default framebuffer with the given viewport
+	void End(int width, int height)
+	{
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glDisable(GL_DEPTH_CLAMP);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	// uploads the matrices if they changed and puts the maps and the block on their bindings,
+	// before drawing with any attached program
+	void Bind()
+	{
+		if (m_BlockDirty)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &m_Block);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			m_BlockDirty = false;
+		}
+		MaterialBindings::Bind(m_FirstUnit, m_Maps[0].texture);
+		MaterialBindings::Bind(m_FirstUnit + 1, m_Maps[1].texture);
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_UBO);
+	}
+
+	// how often the static map was drawn so far
+	unsigned int StaticRenders() const { return m_StaticRenders; }
+
+private:
+	struct Map {
+		int size = 0;
+		GLuint texture = 0;
+		GLuint fbo = 0;
+	};
+
+	// std140 layout of ShadowBlock
+	struct Block {
+		glm::mat4 staticLightSpace;
+		glm::mat4 dynamicLightSpace;
+		glm::vec4 params; // x / y: normal offset of the static / dynamic map in world units, z: strength
+	};
+
+	Map m_Maps[2]; // static, dynamic
+	GLuint m_UBO = 0;
+	GLuint m_Binding;
+	GLuint m_FirstUnit;
+	Block m_Block;
+	bool m_BlockDirty = true;
+	glm::vec3 m_Direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	bool m_StaticValid = false;
+	uint64_t m_StaticVersion = 0;
+	AABB m_StaticBox;
+	unsigned int m_StaticRenders = 0;
+
+	void createMap(Map& map)
+	{
+		glGenTextures(1, &map.texture);
+		glBindTexture(GL_TEXTURE_2D, map.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, map.size, map.size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		// linear + compare mode: every lookup is already a 2x2 PCF
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &map.fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, map.fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, map.texture, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::SHADOW_MAPS:: " << map.size << "x" << map.size << " shadow framebuffer is not complete" << std::endl;
+		// nothing casts until the first pass
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void begin(const Map& map, const glm::mat4& lightSpace, Shader& depthShader)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, map.fbo);
+		glViewport(0, 0, map.size, map.size);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(2.0f, 4.0f);
+		glEnable(GL_DEPTH_CLAMP); // casters between the light and the box still land on its near plane
+		depthShader.use();
+		depthShader.setMat4("lightSpace", lightSpace);
+		m_BlockDirty = true;
+	}
+
+	// Orthographic light matrix around box. The light view only rotates, so moving the box moves the
+	// projection; its origin is snapped to whole texels so edges don't crawl while the box slides.
+	// normalOffset gets the receivers' offset along their normal (1.5 texels in world units).
+	glm::mat4 fit(const AABB& box, int size, float& normalOffset) const
+	{
+		glm::vec3 up = std::abs(m_Direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), m_Direction, up);
+		AABB lightBox;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 p((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z);
+			lightBox.Expand(glm::vec3(lightView * glm::vec4(p, 1.0f)));
+		}
+		glm::vec2 extent = glm::vec2(lightBox.max.x - lightBox.min.x, lightBox.max.y - lightBox.min.y);
+		glm::vec2 texel = extent / (float)size;
+		float left = std::floor(lightBox.min.x / texel.x) * texel.x;
+		float bottom = std::floor(lightBox.min.y / texel.y) * texel.y;
+		normalOffset = 1.5f * std::max(texel.x, texel.y);
+		return glm::ortho(left, left + extent.x, bottom, bottom + extent.y, -lightBox.max.z, -lightBox.min.z) * lightView;
+	}
+};
@@ -0,0 +1,196 @@
+// Skins an animated Model once per frame into its own vertex buffers with transform feedback.
+// Every pass after that (main, shadow, outline...) draws the result with the static
+// (SKIN_INFLUENCES 0) shader instead of redoing the bone math. If the bone palette is
+// identical to the one last captured, the capture is skipped.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <learnopengl/shader.h>
+#include <learnopengl/model_animation.h>
+#include <learnopengl/skinning_shaders.h>
+
+class SkinPrepass
+{
+public:
+	// capture programs for 1, 2 and 4 bone vertices
+	std::vector<Shader> variants;
+	std::vector<GLint> paletteLocations;
+
+	SkinPrepass(const char* vertexPath)
+	{
+		std::vector<const char*> outputs;
+		outputs.push_back("skinnedPos");
+		outputs.push_back("skinnedNormal");
+
+		const int influences[] = { 1, 2, 4 };
+		for (int count : influences)
+		{
+			std::vector<std::string> defines;
+			defines.push_back("SKIN_INFLUENCES " + std::to_string(count));
+			defines.push_back("MAX_MESH_BONES " + std::to_string(MAX_MESH_BONES));
+			variants.push_back(Shader(vertexPath, defines, outputs));
+			paletteLocations.push_back(variants.back().Location("finalBonesMatrices"));
+		}
+	}
+
+	~SkinPrepass()
+	{
+		for (auto& entry : m_Targets)
+		{
+			for (MeshTarget& target : entry.second.meshes)
+			{
+				glDeleteVertexArrays(1, &target.vao);
+				glDeleteBuffers(1, &target.buffer);
+			}
+		}
+	}
+
+	// Skins every skinned mesh of the model into its output buffer. Returns false when the
+	// pose matched the previous capture and nothing had to be done.
+	bool Update(Model& model, const std::vector<glm::mat4>& finalBones)
+	{
+		ModelTargets& targets = getTargets(model);
+		if (targets.captured && samePose(targets.lastPose, finalBones))
+			return false;
+
+		glEnable(GL_RASTERIZER_DISCARD);
+		int bound = -1;
+		for (unsigned int i : model.drawOrder)
+		{
+			Mesh& mesh = model.meshes[i];
+			if (mesh.maxInfluences == 0)
+				continue;
+
+			int variant = mesh.maxInfluences == 1 ? 0 : (mesh.maxInfluences == 2 ? 1 : 2);
+			if (variant != bound)
+			{
+				variants[variant].use();
+				bound = variant;
+			}
+			mesh.UploadBonePalette(paletteLocations[variant], finalBones, m_Palette);
+
+			// the mesh's own VAO supplies the bind pose, one point in = one skinned vertex out
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, targets.meshes[i].buffer);
+			glBindVertexArray(mesh.VAO);
+			glBeginTransformFeedback(GL_POINTS);
+			glDrawArrays(GL_POINTS, 0, (GLsizei)mesh.vertices.size());
+			glEndTransformFeedback();
+		}
+		glBindVertexArray(0);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+		glDisable(GL_RASTERIZER_DISCARD);
+
+		targets.lastPose = finalBones;
+		targets.captured = true;
+		return true;
+	}
+
+	// Draws the last captured pose. staticShader must be a SKIN_INFLUENCES 0 shader with
+	// projection/view already set; meshes without bones use their own VAO as usual.
+	void Draw(Model& model, Shader& staticShader, const glm::mat4& modelMatrix)
+	{
+		ModelTargets& targets = getTargets(model);
+		staticShader.use();
+		staticShader.setMat4("model", modelMatrix);
+		staticShader.setMat3("normalMatrix", NormalMatrix(modelMatrix));
+
+		for (unsigned int i = 0; i < model.meshes.size(); i++)
+		{
+			if (targets.meshes[i].vao != 0)
+				model.meshes[i].Draw(staticShader, targets.meshes[i].vao);
+			else
+				model.meshes[i].Draw(staticShader);
+		}
+	}
+
+	// Positions only, for depth / shadow passes (like Model::DrawDepth): the bound shader must already
+	// have its model matrix, no textures are bound
+	void DrawDepth(Model& model)
+	{
+		ModelTargets& targets = getTargets(model);
+		for (unsigned int i = 0; i < model.meshes.size(); i++)
+		{
+			if (targets.meshes[i].vao != 0)
+			{
+				glBindVertexArray(targets.meshes[i].vao);
+				model.meshes[i].DrawBound(targets.meshes[i].vao);
+			}
+			else
+				model.meshes[i].DrawDepth();
+		}
+		glBindVertexArray(0);
+	}
+
+	// Draw for a RenderQueue: queues the captured pose instead of drawing it
+	void Enqueue(RenderQueue& queue, RenderQueue::Pass pass, Model& model, Shader& staticShader, const glm::mat4& modelMatrix)
+	{
+		ModelTargets& targets = getTargets(model);
+		for (unsigned int i = 0; i < model.meshes.size(); i++)
+			queue.Add(pass, staticShader, model.meshes[i], modelMatrix, 0, targets.meshes[i].vao);
+	}
+
+private:
+	struct MeshTarget
+	{
+		GLuint buffer = 0; // interleaved skinned position + normal
+		GLuint vao = 0;    // that buffer for attributes 0/1, the mesh's VBO and EBO for the rest
+	};
+
+	struct ModelTargets
+	{
+		std::vector<MeshTarget> meshes; // parallel to Model::meshes
+		std::vector<glm::mat4> lastPose;
+		bool captured = false;
+	};
+
+	std::map<const Model*, ModelTargets> m_Targets;
+	std::vector<glm::mat4> m_Palette;
+
+	static bool samePose(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(glm::mat4)) == 0;
+	}
+
+	ModelTargets& getTargets(Model& model)
+	{
+		auto found = m_Targets.find(&model);
+		if (found != m_Targets.end())
+			return found->second;
+
+		ModelTargets& targets = m_Targets[&model];
+		targets.meshes.resize(model.meshes.size());
+		for (unsigned int i = 0; i < model.meshes.size(); i++)
+		{
+			Mesh& mesh = model.meshes[i];
+			if (mesh.maxInfluences == 0)
+				continue;
+
+			MeshTarget& target = targets.meshes[i];
+			const GLsizei stride = 6 * sizeof(float);
+			glGenBuffers(1, &target.buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, target.buffer);
+			glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * stride, NULL, GL_STREAM_COPY);
+
+			glGenVertexArrays(1, &target.vao);
+			glBindVertexArray(target.vao);
+			// skinned position / normal
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+			// texture coords, tangent, bitangent (and texture array layer) straight from the original vertices
+			mesh.SetVertexAttributes(2, 4);
+			mesh.SetVertexAttributes(8, 8);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.GetEBO());
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		return targets;
+	}
+};
@@ -0,0 +1,82 @@
+// anim_model.vs compiled as several variants from the same source (SKIN_INFLUENCES = 0, 1, 2, 4).
+// Each Model is drawn with the cheapest one its vertices need, so static geometry like
+// the stones and the forest never runs the skinning loop.
+// Skinned meshes upload only their own compact bone palette (see Mesh::boneRemap).
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <learnopengl/shader.h>
+#include <learnopengl/model_animation.h>
+
+// Normal matrix done once per draw on the CPU instead of per vertex in the shader
+inline glm::mat3 NormalMatrix(const glm::mat4& model)
+{
+	return glm::mat3(glm::transpose(glm::inverse(model)));
+}
+
+class SkinningShaders
+{
+public:
+	// variants[0] = static, [1] = 1 bone, [2] = 2 bones, [3] = 4 bones
+	std::vector<Shader> variants;
+	// finalBonesMatrices location per variant, looked up once
+	std::vector<GLint> paletteLocations;
+
+	SkinningShaders(const char* vertexPath, const char* fragmentPath)
+	{
+		const int influences[] = { 0, 1, 2, 4 };
+		for (int count : influences)
+		{
+			std::vector<std::string> defines;
+			defines.push_back("SKIN_INFLUENCES " + std::to_string(count));
+			defines.push_back("MAX_MESH_BONES " + std::to_string(MAX_MESH_BONES));
+			variants.push_back(Shader(vertexPath, fragmentPath, defines));
+			paletteLocations.push_back(variants.back().Location("finalBonesMatrices"));
+		}
+	}
+
+	// smallest variant that still covers the given number of bones per vertex
+	Shader& For(int influences) { return variants[variantIndex(influences)]; }
+
+	Shader& For(const Model& model) { return For(model.GetMaxInfluences()); }
+
+	// Draws every mesh with the variant it needs, in drawOrder so each variant is bound once.
+	// finalBones is the animator's full palette; each mesh gets just the bones it uses in one upload.
+	void Draw(Model& model, const std::vector<glm::mat4>& finalBones, const glm::mat4& modelMatrix)
+	{
+		glm::mat3 normalMatrix = NormalMatrix(modelMatrix);
+		int bound = -1;
+
+		for (unsigned int i : model.drawOrder)
+		{
+			Mesh& mesh = model.meshes[i];
+			int variant = variantIndex(mesh.maxInfluences);
+			if (variant != bound)
+			{
+				variants[variant].use();
+				variants[variant].setMat4("model", modelMatrix);
+				variants[variant].setMat3("normalMatrix", normalMatrix);
+				bound = variant;
+			}
+
+			if (variant > 0)
+				mesh.UploadBonePalette(paletteLocations[variant], finalBones, m_Palette);
+
+			mesh.Draw(variants[variant]);
+		}
+	}
+
+private:
+	std::vector<glm::mat4> m_Palette; // reused every draw, grows to MAX_MESH_BONES at most
+
+	int variantIndex(int influences) const
+	{
+		if (influences <= 0) return 0;
+		if (influences == 1) return 1;
+		if (influences == 2) return 2;
+		return 3;
+	}
+};
@@ -0,0 +1,93 @@
+// Packs several 2D textures into the layers of one GL_TEXTURE_2D_ARRAY.
+// Every source is scaled to the common layer size on the GPU (glBlitFramebuffer, linear filter), so
+// meshes that used different textures can be merged and draw in one call, picking their layer per vertex.
+
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <learnopengl/material.h>
+
+class TextureArray
+{
+public:
+	GLuint id = 0;
+	int width = 0, height = 0;
+	std::vector<GLuint> sources; // layer i was copied from sources[i]
+
+	TextureArray() {}
+
+	// layers are the largest source width / height, capped at maxSize
+	TextureArray(const std::vector<GLuint>& textures, int maxSize = 2048)
+		: sources(textures)
+	{
+		if (sources.empty())
+			return;
+
+		MaterialBindings::Invalidate();
+		std::vector<glm::ivec2> sizes;
+		for (GLuint texture : sources)
+		{
+			GLint w = 0, h = 0;
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+			sizes.push_back(glm::ivec2(w, h));
+			width = std::max(width, (int)w);
+			height = std::max(height, (int)h);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		width = std::min(std::max(width, 1), maxSize);
+		height = std::min(std::max(height, 1), maxSize);
+
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, (GLsizei)sources.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		GLint previousRead, previousDraw;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+		GLuint fbos[2];
+		glGenFramebuffers(2, fbos);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+		for (size_t layer = 0; layer < sources.size(); layer++)
+		{
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sources[layer], 0);
+			glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, id, 0, (GLint)layer);
+			if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE ||
+				glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			{
+				std::cout << "ERROR::TEXTURE_ARRAY:: can't copy texture " << sources[layer] << " into layer " << layer << std::endl;
+				continue;
+			}
+			glBlitFramebuffer(0, 0, sizes[layer].x, sizes[layer].y, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+		glDeleteFramebuffers(2, fbos);
+
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	// layer holding texture, -1 if it isn't in the array
+	int LayerOf(GLuint texture) const
+	{
+		auto found = std::find(sources.begin(), sources.end(), texture);
+		return found == sources.end() ? -1 : (int)(found - sources.begin());
+	}
+
+	void Release()
+	{
+		glDeleteTextures(1, &id);
+		id = 0;
+	}
+};
@@ -0,0 +1,38 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D atlas;
+uniform float views;      // tiles side by side in the atlas
+uniform float tileA;
+uniform float tileB;
+uniform float tileBlend;  // 0 = tileA, 1 = tileB
+uniform float fade;       // share of pixels drawn, the mesh draws the rest (see anim_model.fs)
+
+// 4x4 ordered dither, same pattern as anim_model.fs so the two fades never overlap
+float ditherThreshold()
+{
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+    return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+
+void main()
+{
+    if (ditherThreshold() >= fade)
+        discard;
+
+    // keep the lookup half a texel inside the tile so neighbours don't bleed in
+    float inset = 0.5 / float(textureSize(atlas, 0).y);
+    float u = clamp(TexCoords.x, inset, 1.0 - inset);
+    vec4 a = texture(atlas, vec2((tileA + u) / views, TexCoords.y));
+    vec4 b = texture(atlas, vec2((tileB + u) / views, TexCoords.y));
+    vec4 color = mix(a, b, tileBlend);
+
+    if (color.a < 0.5)
+        discard;
+    FragColor = vec4(color.rgb / color.a, 1.0);
+}
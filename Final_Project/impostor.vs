@@ -0,0 +1,26 @@
+#version 330 core
+
+// Camera-facing quad for Impostor: stays upright (rotates around Y only) like the captured views.
+layout(location = 0) in vec2 corner; // -1..1
+
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
+uniform vec3 center;
+uniform vec2 halfSize;
+
+out vec2 TexCoords;
+
+void main()
+{
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 right = normalize(vec3(cameraRight.x, 0.0, cameraRight.z));
+    vec3 worldPos = center + right * corner.x * halfSize.x + vec3(0.0, 1.0, 0.0) * corner.y * halfSize.y;
+
+    TexCoords = corner * 0.5 + 0.5;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -8,11 +8,19 @@ in vec3 Normal;
 uniform vec3 objectColor;
 uniform vec3 lightColor;
 uniform vec3 lightPos;
-uniform vec3 viewPos;
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
 
 uniform vec3 emissionColor;
 uniform float emissionStrength;
 
+#include "clustered_lighting.glsl"
+
 void main()
 {
     // Ambient
@@ -27,26 +35,23 @@ void main()
 
     // Specular
     float specularStrength = 0.4;
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16);
     vec3 specular = specularStrength * spec * lightColor;
 
-    // Emission
-    vec3 emission = emissionColor * emissionStrength;
-
-    float rim = 1.0 - max(dot(norm, viewDir), 0.0);
-    rim = pow(rim, 1.0);     // almost linear very wide halo
-    rim = clamp(rim, 0.0, 1.0);
+    // other orbs' light
+    vec3 clusterDiffuse, clusterSpecular;
+    ClusteredLighting(FragPos, norm, viewDir, 16.0, clusterDiffuse, clusterSpecular);
 
-    vec3 rimGlow = emissionColor * rim * (emissionStrength * 10.0);
+    // Emission, written as is into the HDR target: the halo comes from the bloom pass
+    vec3 emission = emissionColor * emissionStrength;
 
     // Final output
     vec3 result = ambient * objectColor
-                + diffuse * objectColor
-                + specular
-                + emission
-                + rimGlow;   // outer halo
+                + (diffuse + clusterDiffuse) * objectColor
+                + specular + specularStrength * clusterSpecular
+                + emission;
 
     FragColor = vec4(result, 1.0);
 }
@@ -1,19 +1,44 @@
 #version 330 core
+// INDIRECT_DRAW: per-orb matrices from the IndirectDraw storage buffer (see anim_model.vs)
+#ifdef INDIRECT_DRAW
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
+// camera, shared by all programs (FrameUniforms in frame_uniforms.h)
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    float time;
+};
+#ifdef INDIRECT_DRAW
+layout(location = 7) in uint drawIndex;
+struct DrawData {
+    mat4 model;
+    mat4 normalMatrix;
+};
+layout(std430) readonly buffer DrawBlock {
+    DrawData draws[];
+};
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // set per orb from the CPU
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 
 void main()
 {
+#ifdef INDIRECT_DRAW
+    mat4 model = draws[drawIndex].model;
+    mat3 normalMatrix = mat3(draws[drawIndex].normalMatrix);
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D sourceTexture; // the finished HDR frame
+uniform sampler2D bloomTexture;  // its glow at half resolution (Bloom in bloom.h)
+uniform float bloomIntensity;
+uniform float exposure;          // HDR to display: 1 - exp(-color * exposure), bright emission rolls off instead of clipping
+
+void main()
+{
+    vec3 color = texture(sourceTexture, TexCoords).rgb + texture(bloomTexture, TexCoords).rgb * bloomIntensity;
+    color = vec3(1.0) - exp(-color * exposure);
+    FragColor = vec4(color, 1.0);
+}
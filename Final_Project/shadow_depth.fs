@@ -0,0 +1,6 @@
+#version 330 core
+
+// nothing to write but depth
+void main()
+{
+}
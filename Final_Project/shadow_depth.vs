@@ -0,0 +1,13 @@
+#version 330 core
+
+// Depth only pass into a shadow map (ShadowMaps in shadow_maps.h): static meshes through
+// Model::DrawDepth, the character from the skin prepass buffers, so no skinning here.
+layout(location = 0) in vec3 pos;
+
+uniform mat4 lightSpace; // light projection * light view of the map being drawn
+uniform mat4 model;
+
+void main()
+{
+    gl_Position = lightSpace * model * vec4(pos, 1.0);
+}
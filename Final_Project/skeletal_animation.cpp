@@ -9,6 +9,19 @@
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 #include <learnopengl/animation.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/skinning_shaders.h>
+#include <learnopengl/skin_prepass.h>
+#include <learnopengl/impostor.h>
+#include <learnopengl/indirect_draw.h>
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/clustered_lights.h>
+#include <learnopengl/light_probes.h>
+#include <learnopengl/shadow_maps.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/render_graph.h>
+#include <learnopengl/bloom.h>
+#include <learnopengl/dynamic_resolution.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -16,6 +29,7 @@
 #include <iostream>
 #include <vector>
 #include <random>
+#include "world_stream.h"
 
 // Function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -71,14 +85,13 @@ struct Orb {
     float z;
     float speed;
     bool alive = true;
+    int lod = 0; // detail level used last frame, see Model::SelectLod
 };
 std::vector<Orb> orbs;
-
-struct Stone {
-    float x;
-    float scale; // 0.2 or 1.0
-};
-std::vector<Stone> stones;
+// every live orb is also a point light of this color / reach (ClusteredLights)
+const glm::vec3 orbGlowColor(0.3f, 0.5f, 1.0f);
+const float orbLightRadius = 4.0f;
+const float orbLightIntensity = 3.0f;
 
 
 
@@ -116,7 +129,7 @@ glm::mat4 GetBoneMatrix(Model& model, Animator& animator, const std::string& bon
         boneIndex = it->second.id;
     }
     if (boneIndex < 0) return glm::mat4(1.0f);
-    auto boneMatrices = animator.GetFinalBoneMatrices();
+    const auto& boneMatrices = animator.GetFinalBoneMatrices();
     glm::mat4 offset = boneMap[boneName].offset;
     // Model space: final * inverse(offset)
     return boneMatrices[boneIndex] * glm::inverse(offset);
@@ -132,31 +145,31 @@ void PrintAllBoneNames(Model& model) {
     }
 }
 
-void DrawOrbs(
+// orbs go into the frame's render queue, drawn when it executes
+void EnqueueOrbs(
+    RenderQueue& renderQueue,
     std::vector<Orb>& orbs,
     Shader& orbShader,
     Model* lightingOrb,
-    const glm::mat4& view,
     const glm::mat4& projection,
-    const glm::vec3& cameraPos
+    float viewportHeight, // pixels the scene is rendered at, for the LOD choice
+    const glm::vec3& cameraPos,
+    const Frustum& frustum,
+    IndirectDraw* indirect = nullptr // batch the orbs into one call (orbShader is then the INDIRECT_DRAW variant)
     ) {
     if (!lightingOrb) return;
 
     orbShader.use();
-    orbShader.setMat4("view", view);
-    orbShader.setMat4("projection", projection);
-
-    // Basic lighting uniforms (won't go black)
-    orbShader.setVec3("viewPos", cameraPos);
 
+    // Basic lighting uniforms (won't go black), camera comes from FrameUniforms
     glm::vec3 lightPos = cameraPos + glm::vec3(0.0f, 2.0f, 2.0f);
     orbShader.setVec3("lightPos", lightPos);
     orbShader.setVec3("lightColor", glm::vec3(1.0f));
     orbShader.setFloat("ambientStrength", 0.25f);
 
-    // Glow color (optional)
-    orbShader.setVec3("emissionColor", glm::vec3(0.3f, 0.5f, 1.0f));
-    orbShader.setFloat("emissionStrength", 1.0f);
+    // Glow color, over 1 in the HDR target so the bloom pass picks it up
+    orbShader.setVec3("emissionColor", orbGlowColor);
+    orbShader.setFloat("emissionStrength", 3.0f);
 
     for (auto& orb : orbs) {
         if (!orb.alive) continue;
@@ -165,13 +178,19 @@ void DrawOrbs(
         model = glm::translate(model, glm::vec3(orb.x, orb.y, orb.z));
         model = glm::scale(model, glm::vec3(0.05f));
 
-        orbShader.setMat4("model", model);
-
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-        orbShader.setMat3("normalMatrix", normalMatrix);
+        // skip orbs that left the view before touching any uniform
+        if (!frustum.Intersects(lightingOrb->sphere.Transformed(model)))
+            continue;
 
-        lightingOrb->Draw(orbShader);
+        orb.lod = lightingOrb->SelectLod(model, cameraPos, projection, viewportHeight, orb.lod);
+        if (indirect) {
+            indirect->Add(*lightingOrb, model, orb.lod);
+            continue;
+        }
+        lightingOrb->Enqueue(renderQueue, RenderQueue::Opaque, orbShader, model, orb.lod);
     }
+    if (indirect)
+        renderQueue.AddCustom(RenderQueue::Opaque, orbShader, cameraPos, [indirect, &orbShader]() { indirect->Submit(orbShader); });
 }
 
 void DrawBackgroundPic(
@@ -180,13 +199,9 @@ void DrawBackgroundPic(
     GLuint textureID,
     int textureWidth,
     int textureHeight,
-    float scenePosX,
-    const glm::mat4& view,
-    const glm::mat4& projection
+    float scenePosX
 ) {
     picShader.use();
-    picShader.setMat4("view", view);
-    picShader.setMat4("projection", projection);
 
     float scaleX = 100.0f;
     float scaleY = 100.0f;
@@ -201,7 +216,7 @@ void DrawBackgroundPic(
 
     glBindVertexArray(quadVAO);
 
-    glActiveTexture(GL_TEXTURE0);
+    MaterialBindings::Invalidate(); // unit 0 active, mesh texture cache forgotten
     glBindTexture(GL_TEXTURE_2D, textureID);
     picShader.setInt("screenTexture", 0);
 
@@ -240,9 +255,78 @@ int main() {
     stbi_set_flip_vertically_on_load(true);
     glEnable(GL_DEPTH_TEST);
 
-    Shader ourShader("anim_model.vs", "anim_model.fs");
+    // GL 4.3+ contexts draw the stones and orbs with one multi-draw-indirect call each,
+    // older ones keep the per-object uniform + draw path
+    IndirectDraw::Load((GLADloadproc)glfwGetProcAddress);
+    IndirectDraw* stoneIndirect = nullptr; // one each, both are filled before the render queue submits them
+    IndirectDraw* orbIndirect = nullptr;
+    Shader* stoneIndirectShader = nullptr;
+    Shader* orbIndirectShader = nullptr;
+    if (IndirectDraw::Supported()) {
+        stoneIndirect = new IndirectDraw();
+        orbIndirect = new IndirectDraw();
+        stoneIndirectShader = new Shader("anim_model.vs", "anim_model.fs", { "SKIN_INFLUENCES 0", "INDIRECT_DRAW 1" });
+        orbIndirectShader = new Shader("orbShader.vs", "orbShader.fs", { "INDIRECT_DRAW 1" });
+    }
+
+    // static / 1 / 2 / 4 bone variants of anim_model.vs, each Model uses the cheapest one it needs
+    SkinningShaders animShaders("anim_model.vs", "anim_model.fs");
+    SkinPrepass skinPrepass("skin_prepass.vs"); // character skinned once per frame, drawn as static geometry
     Shader picShader("bg_light.vs", "bg_light.fs");
     Shader orbShader("orbShader.vs", "orbShader.fs");
+    Shader impostorShader("impostor.vs", "impostor.fs");
+    // the pre-skinned character, all of its textures in one array (Model::BuildTextureArray), lit by the light probes
+    Shader characterShader("anim_model.vs", "anim_model.fs", { "SKIN_INFLUENCES 0", "TEXTURE_ARRAY 1", "LIGHT_PROBE 1" });
+    // the forest's own static program: its dissolve is program state, so sorted draws can't leak it onto the stones
+    Shader forestShader("anim_model.vs", "anim_model.fs", { "SKIN_INFLUENCES 0" });
+    // the frame's draws, sorted by pass / program / material / vertex array / depth before they are sent
+    RenderQueue renderQueue;
+    // the frame's passes and their transient targets (scene color / depth, post-processing)
+    RenderGraph renderGraph;
+    Shader presentShader("post.vs", "present.fs");
+    GLuint presentUnit = MaterialBindings::UnitFor("sourceTexture");
+    GLuint presentBloomUnit = MaterialBindings::UnitFor("bloomTexture");
+    presentShader.use();
+    presentShader.setFloat("bloomIntensity", 0.8f);
+    presentShader.setFloat("exposure", 1.5f);
+    // glow of everything brighter than 1 (the orbs), a fixed half resolution cost
+    Shader bloomDownShader("post.vs", "bloom_down.fs");
+    Shader bloomUpShader("post.vs", "bloom_up.fs");
+    Bloom bloom(bloomDownShader.ID, bloomUpShader.ID);
+    // GPU time per frame measured with timer queries; over the target the scene is drawn smaller
+    // and stretched back over the window by a sharpening upscale
+    DynamicResolution dynamicResolution(16.0f, 0.5f, 1.0f);
+    Shader upscaleShader("post.vs", "upscale.fs");
+    upscaleShader.use();
+    upscaleShader.setFloat("sharpness", 0.5f);
+    // projection / view / camera position / time, uploaded once per frame for every program
+    FrameUniforms frameUniforms;
+    // orb lights binned into screen / depth clusters; every program with ClusterBlock has to be attached
+    ClusteredLights orbLights(Shader::BlockBinding("ClusterBlock"));
+    for (Shader& variant : animShaders.variants)
+        orbLights.Attach(variant.ID);
+    orbLights.Attach(orbShader.ID);
+    orbLights.Attach(forestShader.ID);
+    if (stoneIndirectShader) orbLights.Attach(stoneIndirectShader->ID);
+    if (orbIndirectShader) orbLights.Attach(orbIndirectShader->ID);
+    orbLights.Bind(); // no lights yet, but the impostor capture below already draws with anim_model
+    // sun shadows: stones and forest in a cached map that follows the course, character and orbs in a
+    // small map redrawn every frame; every anim_model program samples both
+    Shader shadowDepthShader("shadow_depth.vs", "shadow_depth.fs");
+    ShadowMaps shadows(Shader::BlockBinding("ShadowBlock"));
+    for (Shader& variant : animShaders.variants)
+        shadows.Attach(variant.ID);
+    shadows.Attach(characterShader.ID);
+    shadows.Attach(forestShader.ID);
+    if (stoneIndirectShader) shadows.Attach(stoneIndirectShader->ID);
+    shadows.Bind(); // empty maps at strength 0 for the impostor capture
+    shadows.SetLight(glm::vec3(0.6f, -1.0f, -0.3f), 0.5f);
+
+    // import each model with only the vertex attributes its shaders read
+    const unsigned int staticAttribs = VertexAttribsOf(animShaders.For(0));
+    const unsigned int characterAttribs = staticAttribs | VertexAttribsOf(skinPrepass.variants.back());
+    // 50/25/10% triangle versions for props that are often only a few pixels big
+    const std::vector<float> propLods = { 0.5f, 0.25f, 0.1f };
 
     // Resource paths
     const std::string modelPath = FileSystem::getPath("resources/objects/goth_katana/run.dae");
@@ -253,16 +337,25 @@ int main() {
 
 
     const std::string katanaPath = FileSystem::getPath("resources/objects/katana/katana.dae");
-    Model* katana = fileExists(katanaPath) ? new Model(katanaPath) : nullptr;
+    Model* katana = fileExists(katanaPath) ? new Model(katanaPath, false, staticAttribs) : nullptr;
 
     const std::string lightingOrbPath = FileSystem::getPath("resources/objects/bullets/blue_orb/blue_orb.obj");
-    Model* lightingOrb = fileExists(lightingOrbPath) ? new Model(lightingOrbPath) : nullptr;
+    Model* lightingOrb = fileExists(lightingOrbPath) ? new Model(lightingOrbPath, false, VertexAttribsOf(orbShader), propLods) : nullptr;
 
     const std::string forestPath = FileSystem::getPath("resources/objects/winter_forest/winter_forest.dae");
-    Model* forest = fileExists(forestPath) ? new Model(forestPath) : nullptr;
+    Model* forest = fileExists(forestPath) ? new Model(forestPath, false, staticAttribs, propLods) : nullptr;
+
+    // one draw per texture set instead of one per tree mesh
+    if (forest) forest->BatchStaticMeshes();
+
+    // the forest only ever slides along x, so its rotation/scale can be baked into an impostor once
+    glm::mat4 forestOrientation = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f, 1.0f, 0.1f));
+    forestOrientation = glm::rotate(forestOrientation, glm::radians(180.0f), glm::vec3(1, 0, 0));
+    forestOrientation = glm::rotate(forestOrientation, glm::radians(45.0f), glm::vec3(0, 1, 0));
+    Impostor* forestImpostor = forest ? new Impostor(*forest, animShaders.For(*forest), forestOrientation) : nullptr;
 
     const std::string stonePath = FileSystem::getPath("resources/objects/winter_forest/black_energy.dae");
-    Model* stoneModel = fileExists(stonePath) ? new Model(stonePath) : nullptr;
+    Model* stoneModel = fileExists(stonePath) ? new Model(stonePath, false, staticAttribs, propLods) : nullptr;
 
     stbi_set_flip_vertically_on_load(true);
     unsigned int bg = loadTexture(FileSystem::getPath("resources/textures/grey_wall.jpg").c_str());
@@ -275,7 +368,8 @@ int main() {
         return -1;
     }
 
-    Model ourModel(modelPath);
+    Model ourModel(modelPath, false, characterAttribs);
+    ourModel.BuildTextureArray(); // Body, Hair, Eye, Outfit... in as few draws as the bone palettes allow
     //PrintAllBoneNames(ourModel);
 
     // Try loading each animation safely
@@ -305,23 +399,29 @@ int main() {
     glm::vec3 katanaRotHand(0.0f, 90.0f, 0.0f);
     glm::vec3 katanaOffsetHand(0.1f, 0.1f, 0.1f);
 
-    /////generate Stone
-    std::vector<Stone> stones;
-    int maxX = 200; // Max range for obstacles
-
+    /////stream Stones (endless course)
     std::random_device rd;
-    std::mt19937 generator(rd());
-    std::bernoulli_distribution spawnDist(1.0); // 50% chance to spawn stone
-    std::bernoulli_distribution scaleDist(0.5); // 50% chance to pick 1.0, else 0.2
-
-    for (int x = 25; x <= maxX; x += 5) {
-        if (spawnDist(generator)) {
-            Stone s;
-            s.x = float(x) + ((rand() % 100) / 100.0f - 0.5f); // optional small random X offset ±0.5
-            s.scale = scaleDist(generator) ? 1.0f : 0.2f;
-            stones.push_back(s);
-        }
-    }
+    WorldStreamSettings worldSettings;
+    worldSettings.seed = rd();            // fix this to replay the same course
+    worldSettings.spawnChance = 1.0f;     // every slot gets a stone
+    worldSettings.bigStoneChance = 0.5f;  // 50% chance to pick 1.0, else 0.2
+    WorldStreamer world(worldSettings);
+
+    // static lights and environment of the course, baked into SH probes for the character; one lantern
+    // per chunk, so the probe grid covers one chunk and wraps (rebasing moves by whole chunks)
+    ProbeEnvironment courseEnvironment;
+    courseEnvironment.skyColor = glm::vec3(1.05f, 1.05f, 1.1f);
+    courseEnvironment.groundColor = glm::vec3(0.55f, 0.5f, 0.45f);
+    courseEnvironment.wallColor = LightProbeGrid::AverageColor(bg); // the background picture behind the course
+    courseEnvironment.wallAngle = glm::radians(50.0f);
+    courseEnvironment.period = worldSettings.chunkLength;
+    courseEnvironment.lights.push_back({ glm::vec3(12.5f, 1.5f, -2.0f), 8.0f, glm::vec3(1.0f, 0.7f, 0.4f) * 2.0f });
+    LightProbeGrid courseProbes(glm::vec3(0.0f, -0.4f, 0.0f), glm::vec3(worldSettings.chunkLength / 10.0f, 1.0f, 1.0f),
+        glm::ivec3(10, 3, 1), true);
+    courseProbes.Bake(courseEnvironment);
+
+    float forestX = 40.0f;
+    int forestLod = 0;
 
 
     //// quad vertice (test)
@@ -366,6 +466,16 @@ int main() {
         if (charState) {
             scenePosX += speed * deltaTime;
         }
+        world.Update(scenePosX);
+
+        // keep scene coordinates small so float precision holds on long runs
+        float rebaseShift = world.Rebase(scenePosX);
+        if (rebaseShift != 0.0f) {
+            scenePosX -= rebaseShift;
+            forestX -= rebaseShift;
+            for (auto& orb : orbs)
+                orb.x -= rebaseShift;
+        }
         camera.Position.x = scenePosX + 1.0f; // start at x=2, move with scene
 
         // --- Player position & jump logic ---
@@ -402,22 +512,24 @@ int main() {
         float playerX = scenePosX;
         float playerY = posY; // bottom of player
 
-        for (auto& stone : stones) {
-            float stoneX = stone.x;
-            float stoneY = 0.0f;                  // ground level
-            float stoneWidth = stone.scale + 0.1f;  // half-width scaled
-            float stoneHeight = 0.25f * stone.scale;  // height scaled
+        for (auto& chunk : world.Chunks()) {
+            for (auto& stone : chunk.stones) {
+                float stoneX = stone.x;
+                float stoneY = 0.0f;                  // ground level
+                float stoneWidth = stone.scale + 0.1f;  // half-width scaled
+                float stoneHeight = 0.25f * stone.scale;  // height scaled
 
-            // X collision
-            bool collideX = fabsf(stoneX - playerX) < stoneWidth;
+                // X collision
+                bool collideX = fabsf(stoneX - playerX) < stoneWidth;
 
-            // Y collision: check vertical overlap
-            bool collideY = (playerY < stoneY + stoneHeight) && (playerY + playerHeight > stoneY);
+                // Y collision: check vertical overlap
+                bool collideY = (playerY < stoneY + stoneHeight) && (playerY + playerHeight > stoneY);
 
-            if (collideX && collideY) {
-                std::cout << "Player died! Collided with stone at X = " << stoneX << std::endl;
-                glfwSetWindowShouldClose(window, true);
-                break;
+                if (collideX && collideY) {
+                    std::cout << "Player died! Collided with stone at X = " << world.WorldX(stoneX) << std::endl;
+                    glfwSetWindowShouldClose(window, true);
+                    break;
+                }
             }
         }
 
@@ -659,29 +771,32 @@ int main() {
         for (auto& orb : orbs) {
             if (!orb.alive) continue;
 
-            for (size_t i = 0; i < stones.size(); ) {
-                Stone& stone = stones[i];
-                float stoneX = stone.x;
-                float stoneY = 0.0f;                  // ground level
-                float stoneWidth = 0.5f * stone.scale;  // half-width scaled
-                float stoneHeight = stone.scale;  // height scaled
-
-                float orbX = orb.x;
-                float orbY = orb.y;
-                float orbRadius = 0.1f; // adjust as needed
-
-                // X overlap
-                bool collideX = fabsf(stoneX - orbX) < (stoneWidth + orbRadius);
-
-                // Y overlap
-                bool collideY = (orbY < stoneY + stoneHeight) && (orbY + orbRadius > stoneY);
-
-                if (collideX && collideY) {
-                    stones.erase(stones.begin() + i); // remove stone
-                    orb.alive = false;                // destroy orb
-                }
-                else {
-                    ++i;
+            for (auto& chunk : world.Chunks()) {
+                std::vector<Stone>& stones = chunk.stones;
+                for (size_t i = 0; i < stones.size(); ) {
+                    Stone& stone = stones[i];
+                    float stoneX = stone.x;
+                    float stoneY = 0.0f;                  // ground level
+                    float stoneWidth = 0.5f * stone.scale;  // half-width scaled
+                    float stoneHeight = stone.scale;  // height scaled
+
+                    float orbX = orb.x;
+                    float orbY = orb.y;
+                    float orbRadius = 0.1f; // adjust as needed
+
+                    // X overlap
+                    bool collideX = fabsf(stoneX - orbX) < (stoneWidth + orbRadius);
+
+                    // Y overlap
+                    bool collideY = (orbY < stoneY + stoneHeight) && (orbY + orbRadius > stoneY);
+
+                    if (collideX && collideY) {
+                        world.RemoveStone(chunk, i);      // remove stone, bumps world.Version() for the shadow cache
+                        orb.alive = false;                // destroy orb
+                    }
+                    else {
+                        ++i;
+                    }
                 }
             }
         }
@@ -698,18 +813,26 @@ int main() {
         // -------------------------------
 
         // Render
-        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        ourShader.use();
+        dynamicResolution.BeginFrame();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-
-        auto transforms = animator.GetFinalBoneMatrices();
-        for (int i = 0; i < (int)transforms.size(); ++i)
-            ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+        frameUniforms.Update(projection, view, camera.Position, currentFrame);
+
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glm::ivec2 renderSize = dynamicResolution.ScaledSize(framebufferWidth, framebufferHeight);
+        orbLights.Clear();
+        // the lanterns on screen, everything but the character gets them per pixel
+        float period = courseEnvironment.period;
+        for (float chunkX = std::floor((scenePosX - 20.0f) / period) * period; chunkX < scenePosX + worldSettings.generateAhead; chunkX += period)
+            for (const ProbeLight& lantern : courseEnvironment.lights)
+                orbLights.Add(lantern.position + glm::vec3(chunkX, 0.0f, 0.0f), lantern.radius, lantern.color);
+        for (const Orb& orb : orbs)
+            if (orb.alive)
+                orbLights.Add(glm::vec3(orb.x, orb.y, orb.z), orbLightRadius, orbGlowColor * orbLightIntensity);
+        orbLights.Update(view, projection, renderSize.x, renderSize.y); // clusters are looked up from gl_FragCoord
+        orbLights.Bind();
+        Frustum frustum(projection * view);
 
         //draw model
         glm::mat4 model = glm::mat4(1.0f);
@@ -718,9 +841,67 @@ int main() {
         model = glm::translate(model, glm::vec3(scenePosX, posY, 0.0f));
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0, 1, 0));
         model = glm::scale(model, glm::vec3(0.5f));
-        ourShader.setMat4("model", model);
 
-        ourModel.Draw(ourShader);
+        // animated bound from the bone palette (follows jumps, crouches, raised arms)
+        const auto& transforms = animator.GetFinalBoneMatrices();
+        AABB characterBounds = ourModel.GetSkinnedBounds(transforms).Transformed(model);
+
+        // skin even when off screen, later passes (shadows) still need the pose
+        skinPrepass.Update(ourModel, transforms);
+
+        // static shadow casters, only when the map moved on (whole chunks) or a stone appeared or was shot;
+        // it spans from behind the view to past its far edge, depth clamp keeps the tall trees above it
+        float shadowStart = std::floor((scenePosX - 20.0f) / period) * period;
+        AABB staticShadowBox;
+        staticShadowBox.min = glm::vec3(shadowStart, -1.5f, -25.0f);
+        staticShadowBox.max = glm::vec3(shadowStart + 4.0f * period, 2.0f, 2.0f);
+        if (shadows.BeginStatic(staticShadowBox, world.Version(), shadowDepthShader)) {
+            Shader::Uniform<glm::mat4> shadowModelUniform = shadowDepthShader.GetUniform<glm::mat4>("model");
+            for (auto& chunk : world.Chunks()) {
+                if (!stoneModel) break;
+                for (auto& stone : chunk.stones) {
+                    glm::mat4 stoneModelMat = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(stone.x, -0.2f, 0.0f)), glm::vec3(stone.scale));
+                    shadowDepthShader.set(shadowModelUniform, stoneModelMat);
+                    stoneModel->DrawDepth();
+                }
+            }
+            if (forest) {
+                shadowDepthShader.set(shadowModelUniform, glm::translate(glm::mat4(1.0f), glm::vec3(forestX, -1.4f, -20.0f)) * forestOrientation);
+                forest->DrawDepth();
+            }
+            shadows.End(framebufferWidth, framebufferHeight);
+        }
+
+        // moving casters around the player, every frame (the box keeps its size so its texels stay put)
+        AABB dynamicShadowBox;
+        dynamicShadowBox.min = glm::vec3(scenePosX - 1.5f, -0.6f, -1.5f);
+        dynamicShadowBox.max = glm::vec3(scenePosX + 4.5f, 2.5f, 1.5f);
+        shadows.BeginDynamic(dynamicShadowBox, shadowDepthShader);
+        Shader::Uniform<glm::mat4> shadowModelUniform = shadowDepthShader.GetUniform<glm::mat4>("model");
+        shadowDepthShader.set(shadowModelUniform, model);
+        skinPrepass.DrawDepth(ourModel);
+        if (lightingOrb) {
+            for (const Orb& orb : orbs) {
+                if (!orb.alive) continue;
+                shadowDepthShader.set(shadowModelUniform, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(orb.x, orb.y, orb.z)), glm::vec3(0.05f)));
+                lightingOrb->DrawDepth(lightingOrb->LodCount() - 1); // a few texels big, the coarsest level does
+            }
+        }
+        shadows.End(framebufferWidth, framebufferHeight);
+        shadows.Bind();
+
+        renderQueue.Begin(view, 100.0f);
+        if (frustum.Intersects(characterBounds)) {
+            // baked probes at the character's chest plus the orbs close by, 9 uniforms in total
+            glm::vec3 characterCenter(scenePosX, posY + 0.8f, 0.0f);
+            SH9 characterLight = courseProbes.Sample(characterCenter);
+            for (const Orb& orb : orbs)
+                if (orb.alive)
+                    characterLight.AddPointLight(characterCenter, glm::vec3(orb.x, orb.y, orb.z), orbLightRadius, orbGlowColor * orbLightIntensity);
+            characterShader.use();
+            glUniform3fv(characterShader.Location("shIrradiance"), 9, &characterLight.c[0][0]);
+            skinPrepass.Enqueue(renderQueue, RenderQueue::Opaque, ourModel, characterShader, model);
+        }
 
         //if (katana && charState == MAGIC) { // Only draw katana while slashing
         //    glm::mat4 boneMat = GetBoneMatrix(ourModel, animator, handBone);
@@ -741,8 +922,10 @@ int main() {
 
 
 
-        for (auto& stone : stones) {
-            if (stone.x > 0) {
+        Shader* stoneShader = stoneModel ? (stoneIndirect ? stoneIndirectShader : &animShaders.For(*stoneModel)) : nullptr;
+        for (auto& chunk : world.Chunks()) {
+            if (!stoneModel) break;
+            for (auto& stone : chunk.stones) {
                 glm::mat4 stoneModelMat = glm::mat4(1.0f);
 
                 // Translate to stone position
@@ -751,38 +934,84 @@ int main() {
                 // Scale according to random scale
                 stoneModelMat = glm::scale(stoneModelMat, glm::vec3(stone.scale));
 
-                // Set shader and draw
-                ourShader.setMat4("model", stoneModelMat);
+                // Off-screen stones are dropped here, before any uniform or draw
+                if (!frustum.Intersects(stoneModel->aabb.Transformed(stoneModelMat)))
+                    continue;
+
+                stone.lod = stoneModel->SelectLod(stoneModelMat, camera.Position, projection, (float)renderSize.y, stone.lod);
+                if (stoneIndirect) {
+                    stoneIndirect->Add(*stoneModel, stoneModelMat, stone.lod);
+                    continue;
+                }
 
-                // Use your mesh pointer, not the struct
-                stoneModel->Draw(ourShader);  // <-- or whatever your Mesh* is
+                // model / normal matrix are set by the queue, only when they change
+                stoneModel->Enqueue(renderQueue, RenderQueue::Opaque, *stoneShader, stoneModelMat, stone.lod);
             }
         }
+        if (stoneShader && stoneIndirect)
+            renderQueue.AddCustom(RenderQueue::Opaque, *stoneShader, camera.Position, [&]() { stoneIndirect->Submit(*stoneShader); });
 
 
         if (forest) {
             glm::mat4 forestModel = glm::mat4(1.0f);
-            forestModel = glm::translate(forestModel, glm::vec3(40.0f, -1.4f, -20.0f)); // Try moving first
-            forestModel = glm::scale(forestModel, glm::vec3(0.1f, 1.0f, 0.1f));
-            forestModel = glm::rotate(forestModel, glm::radians(180.0f), glm::vec3(1, 0, 0));
-            forestModel = glm::rotate(forestModel, glm::radians(45.0f), glm::vec3(0, 1, 0));  // 4. Translate last
-            ourShader.setMat4("model", forestModel);
-            forest->Draw(ourShader);
+            glm::vec3 forestPos(forestX, -1.4f, -20.0f);
+            forestModel = glm::translate(forestModel, forestPos) * forestOrientation; // Try moving first
+
+            // far away the forest is a single quad, in the hand-over band both are dithered
+            float forestFade = forestImpostor ? forestImpostor->Fade(forestPos, camera.Position) : 0.0f;
+            if (forestFade < 1.0f && frustum.Intersects(forest->aabb.Transformed(forestModel))) {
+                forestShader.use();
+                forestShader.setFloat("dissolve", forestFade);
+                forestLod = forest->SelectLod(forestModel, camera.Position, projection, (float)renderSize.y, forestLod);
+                forest->Enqueue(renderQueue, RenderQueue::Opaque, forestShader, forestModel, forestLod, &frustum); // per-mesh culling
+            }
+            if (forestFade > 0.0f && frustum.Intersects(forestImpostor->Bounds(forestPos))) {
+                renderQueue.AddCustom(RenderQueue::Opaque, impostorShader, forestPos, [&, forestPos, forestFade]() {
+                    forestImpostor->Draw(impostorShader, forestPos, camera.Position, forestFade);
+                });
+            }
         }
 
-        orbShader.use();
-        orbShader.setMat4("view", view);
-        orbShader.setMat4("projection", projection);
-
-        DrawOrbs(orbs, orbShader, lightingOrb, view, projection, camera.Position);
+        Shader& orbDrawShader = orbIndirectShader ? *orbIndirectShader : orbShader;
+        EnqueueOrbs(renderQueue, orbs, orbDrawShader, lightingOrb, projection, (float)renderSize.y, camera.Position, frustum, orbIndirect);
 
         //////////////////PICS
-        // bind the background shader
-        picShader.use();
-        picShader.setMat4("view", view);
-        picShader.setMat4("projection", projection);
-        DrawBackgroundPic(picShader, quadVAO, bg, textureWidth, textureHeight,
-            scenePosX, view, projection);
+        // the background quad covers whatever is left once the depth buffer is full
+        renderQueue.AddCustom(RenderQueue::Background, picShader, glm::vec3(scenePosX, -0.4f, -70.0f), [&]() {
+            DrawBackgroundPic(picShader, quadVAO, bg, textureWidth, textureHeight, scenePosX);
+        });
+
+        // the scene is drawn into transient targets, later passes read it from there and the last one
+        // writes the backbuffer; the graph culls what isn't read and lets targets share textures
+        renderGraph.Begin(framebufferWidth, framebufferHeight);
+        RenderGraph::Resource sceneColor = renderGraph.Create("sceneColor", { renderSize.x, renderSize.y, GL_RGBA16F });
+        RenderGraph::Resource sceneDepth = renderGraph.Create("sceneDepth", { renderSize.x, renderSize.y, GL_DEPTH_COMPONENT24 });
+        renderGraph.AddPass("scene", {}, { sceneColor, sceneDepth }, [&]() {
+            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderQueue.Execute();
+        });
+        RenderGraph::Resource sceneBloom = bloom.AddPasses(renderGraph, sceneColor);
+        // at a reduced scale the composed frame stays at the render size and is upscaled to the window
+        bool upscale = renderSize.x != framebufferWidth || renderSize.y != framebufferHeight;
+        RenderGraph::Resource frame = upscale ? renderGraph.Create("frame", { renderSize.x, renderSize.y, GL_RGBA8 }) : RenderGraph::Backbuffer;
+        renderGraph.AddPass("present", { sceneColor, sceneBloom }, { frame }, [&]() {
+            presentShader.use();
+            MaterialBindings::Prepare(presentShader.ID);
+            MaterialBindings::Bind(presentUnit, renderGraph.Texture(sceneColor));
+            MaterialBindings::Bind(presentBloomUnit, renderGraph.Texture(sceneBloom));
+            renderGraph.DrawFullscreenTriangle();
+        });
+        if (upscale) {
+            renderGraph.AddPass("upscale", { frame }, { RenderGraph::Backbuffer }, [&]() {
+                upscaleShader.use();
+                MaterialBindings::Prepare(upscaleShader.ID);
+                MaterialBindings::Bind(presentUnit, renderGraph.Texture(frame));
+                renderGraph.DrawFullscreenTriangle();
+            });
+        }
+        renderGraph.Execute();
+        dynamicResolution.EndFrame();
 
 
         glfwSwapBuffers(window);
@@ -791,6 +1020,11 @@ int main() {
 
     delete idleAnimation;
     delete shootMagicAnimation;
+    delete forestImpostor; // owns a texture, release it while the context is still alive
+    delete stoneIndirect;
+    delete orbIndirect;
+    delete stoneIndirectShader;
+    delete orbIndirectShader;
     glfwTerminate();
     return 0;
 }
@@ -822,6 +1056,7 @@ unsigned int loadTexture(char const* path)
         else if (nrComponents == 4)
             format = GL_RGBA;
 
+        MaterialBindings::Invalidate();
         glBindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -0,0 +1,35 @@
+#version 330 core
+
+// Skinning only, no rasterization: SkinPrepass captures skinnedPos/skinnedNormal
+// into a buffer with transform feedback, once per frame per animated model.
+// Same bone layout and defines as anim_model.vs.
+#ifndef SKIN_INFLUENCES
+#define SKIN_INFLUENCES 4
+#endif
+#ifndef MAX_MESH_BONES
+#define MAX_MESH_BONES 64
+#endif
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 norm;
+layout(location = 5) in ivec4 boneIds;
+layout(location = 6) in vec4 weights;
+
+uniform mat4 finalBonesMatrices[MAX_MESH_BONES];
+
+out vec3 skinnedPos;    // model space
+out vec3 skinnedNormal;
+
+void main()
+{
+    mat4 skin = finalBonesMatrices[boneIds.x] * weights.x;
+#if SKIN_INFLUENCES > 1
+    skin += finalBonesMatrices[boneIds.y] * weights.y;
+#endif
+#if SKIN_INFLUENCES > 2
+    skin += finalBonesMatrices[boneIds.z] * weights.z;
+    skin += finalBonesMatrices[boneIds.w] * weights.w;
+#endif
+    skinnedPos = vec3(skin * vec4(pos, 1.0));
+    skinnedNormal = mat3(skin) * norm;
+}
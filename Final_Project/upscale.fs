@@ -0,0 +1,23 @@
+#version 330 core
+// the scene rendered at a lower resolution (DynamicResolution) stretched over the window: bilinear,
+// then sharpened against the 4 neighbours and clamped to their range so edges don't ring
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D sourceTexture;
+uniform float sharpness; // 0 = plain bilinear, 1 = strongest
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(sourceTexture, 0));
+    vec3 center = texture(sourceTexture, TexCoords).rgb;
+    vec3 north = texture(sourceTexture, TexCoords + vec2(0.0, texel.y)).rgb;
+    vec3 south = texture(sourceTexture, TexCoords - vec2(0.0, texel.y)).rgb;
+    vec3 east = texture(sourceTexture, TexCoords + vec2(texel.x, 0.0)).rgb;
+    vec3 west = texture(sourceTexture, TexCoords - vec2(texel.x, 0.0)).rgb;
+    vec3 lowest = min(center, min(min(north, south), min(east, west)));
+    vec3 highest = max(center, max(max(north, south), max(east, west)));
+    vec3 sharpened = center + (4.0 * center - north - south - east - west) * (0.25 * sharpness);
+    FragColor = vec4(clamp(sharpened, lowest, highest), 1.0);
+}
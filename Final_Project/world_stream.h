@@ -0,0 +1,164 @@
+// Endless course generator for the runner.
+// Obstacles are produced chunk by chunk ahead of the player from a seeded RNG,
+// chunks that fall behind the camera go back into a pool and get reused, and the
+// whole scene is shifted back toward x = 0 every so often so floats stay precise.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct Stone {
+    float x;
+    float scale; // 0.2 or 1.0
+    int lod = 0; // detail level drawn last frame
+};
+
+struct WorldChunk {
+    int64_t index = 0;          // global chunk number, unaffected by rebasing
+    float startX = 0.0f;        // scene-space x where this chunk begins
+    std::vector<Stone> stones;
+};
+
+struct WorldStreamSettings {
+    uint32_t seed = 1;
+    float chunkLength = 25.0f;      // world units per chunk
+    float stoneSpacing = 5.0f;      // one stone slot every N units
+    float firstStoneX = 25.0f;      // empty run-up before the first obstacle
+    float generateAhead = 60.0f;    // keep the course built this far past the player
+    float keepBehind = 10.0f;       // retire a chunk once it ends this far behind the player
+    float rebaseDistance = 1000.0f; // shift the scene back once the player passes this x
+    float spawnChance = 1.0f;       // chance a slot gets a stone at all
+    float bigStoneChance = 0.5f;    // chance a stone is the 1.0 scale one instead of 0.2
+};
+
+class WorldStreamer
+{
+public:
+    WorldStreamer(const WorldStreamSettings& settings)
+        : m_Settings(settings)
+    {
+        // Everything is sized once up front, so streaming never allocates afterwards
+        int slotsPerChunk = (int)std::ceil(m_Settings.chunkLength / m_Settings.stoneSpacing);
+        int maxChunks = (int)std::ceil((m_Settings.generateAhead + m_Settings.keepBehind) / m_Settings.chunkLength) + 2;
+
+        m_Active.reserve(maxChunks);
+        m_Pool.reserve(maxChunks);
+        for (int i = 0; i < maxChunks; i++) {
+            WorldChunk chunk;
+            chunk.stones.reserve(slotsPerChunk);
+            m_Pool.push_back(std::move(chunk));
+        }
+    }
+
+    // Retire chunks behind the player and build new ones until the course reaches generateAhead
+    void Update(float playerX)
+    {
+        while (!m_Active.empty() &&
+            m_Active.front().startX + m_Settings.chunkLength < playerX - m_Settings.keepBehind) {
+            m_Pool.push_back(std::move(m_Active.front()));
+            m_Active.erase(m_Active.begin());
+            m_Version++;
+        }
+
+        while (ChunkStartX(m_NextChunk) < playerX + m_Settings.generateAhead) {
+            WorldChunk chunk;
+            if (!m_Pool.empty()) {
+                chunk = std::move(m_Pool.back());
+                m_Pool.pop_back();
+            }
+            GenerateChunk(chunk, m_NextChunk++);
+            m_Active.push_back(std::move(chunk));
+            m_Version++;
+        }
+    }
+
+    // Once the player is past rebaseDistance, move the scene origin forward by whole chunks.
+    // Returns how far everything was shifted (0 if nothing happened); the caller must
+    // subtract the same amount from anything else it keeps in scene space.
+    float Rebase(float playerX)
+    {
+        if (playerX < m_Settings.rebaseDistance)
+            return 0.0f;
+
+        int64_t chunks = (int64_t)std::floor(playerX / m_Settings.chunkLength);
+        float shift = chunks * m_Settings.chunkLength;
+        m_OriginChunk += chunks;
+
+        for (auto& chunk : m_Active) {
+            chunk.startX -= shift;
+            for (auto& stone : chunk.stones)
+                stone.x -= shift;
+        }
+        m_Version++;
+        return shift;
+    }
+
+    // Distance from the very start of the run, for scoring and logs
+    double WorldX(float sceneX) const
+    {
+        return (double)m_OriginChunk * m_Settings.chunkLength + sceneX;
+    }
+
+    std::vector<WorldChunk>& Chunks() { return m_Active; }
+
+    // Removes a destroyed stone (the chunk keeps its capacity)
+    void RemoveStone(WorldChunk& chunk, size_t index)
+    {
+        chunk.stones.erase(chunk.stones.begin() + index);
+        m_Version++;
+    }
+
+    // Changes whenever a stone appears, disappears or moves, for caches of the static course (shadows)
+    uint64_t Version() const { return m_Version; }
+
+private:
+    WorldStreamSettings m_Settings;
+    std::vector<WorldChunk> m_Active; // ordered by chunk index, oldest first
+    std::vector<WorldChunk> m_Pool;
+    int64_t m_NextChunk = 0;
+    int64_t m_OriginChunk = 0;        // chunks removed from scene space by rebasing
+    uint64_t m_Version = 0;
+
+    float ChunkStartX(int64_t index) const
+    {
+        return (float)(index - m_OriginChunk) * m_Settings.chunkLength;
+    }
+
+    // The same index always yields the same stones, no matter when it is generated
+    uint64_t ChunkSeed(int64_t index) const
+    {
+        uint64_t z = ((uint64_t)m_Settings.seed << 32) ^ (uint64_t)index;
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    void GenerateChunk(WorldChunk& chunk, int64_t index)
+    {
+        chunk.index = index;
+        chunk.startX = ChunkStartX(index);
+        chunk.stones.clear();
+
+        std::mt19937 generator((uint32_t)ChunkSeed(index));
+        std::bernoulli_distribution spawnDist(m_Settings.spawnChance);
+        std::bernoulli_distribution scaleDist(m_Settings.bigStoneChance);
+        std::uniform_real_distribution<float> jitterDist(-0.5f, 0.5f); // small random X offset
+
+        double chunkWorldX = (double)index * m_Settings.chunkLength;
+        for (float offset = 0.0f; offset < m_Settings.chunkLength; offset += m_Settings.stoneSpacing) {
+            if (chunkWorldX + offset < m_Settings.firstStoneX)
+                continue;
+            if (!spawnDist(generator))
+                continue;
+
+            Stone s;
+            s.x = chunk.startX + offset + jitterDist(generator);
+            s.scale = scaleDist(generator) ? 1.0f : 0.2f;
+            chunk.stones.push_back(s);
+        }
+    }
+};